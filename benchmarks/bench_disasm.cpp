@@ -0,0 +1,227 @@
+// Micro-benchmarks of the disassembler C API.
+//
+// Feeds byte streams of several targets through the bap_disasm_*
+// functions in the single-step, sweep and stop-on-branch modes, with
+// and without stored asm strings and predicates, and reports the
+// throughput in instructions per second.
+//
+// Streams are built by repeating short snippets of typical compiler
+// output up to the size of a small text section. Recorded streams
+// can be added on the command line as TRIPLE=FILE pairs, where FILE
+// contains raw code, e.g., extracted with objcopy -O binary.
+//
+// Build and run with `make bench-disasm`.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "disasm.h"
+#include "llvm_disasm.h"
+}
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+const std::size_t stream_size = 1 << 20;
+const int64_t base_address = 0x10000;
+
+// a loop with a call, as emitted by a compiler without optimizations
+const uint8_t x86_64_code[] = {
+    0x55, 0x48, 0x89, 0xe5, 0x53, 0x48, 0x83, 0xec, 0x28, 0x48, 0x89, 0x7d,
+    0xd8, 0x89, 0x75, 0xd4, 0xc7, 0x45, 0xec, 0x00, 0x00, 0x00, 0x00, 0xeb,
+    0x23, 0x8b, 0x45, 0xec, 0x48, 0x63, 0xd0, 0x48, 0x8b, 0x45, 0xd8, 0x48,
+    0x01, 0xd0, 0x0f, 0xb6, 0x00, 0x0f, 0xbe, 0xc0, 0x8d, 0x0c, 0x85, 0x00,
+    0x00, 0x00, 0x00, 0x6b, 0xc9, 0x1f, 0x31, 0xcb, 0x83, 0x45, 0xec, 0x01,
+    0x8b, 0x45, 0xec, 0x3b, 0x45, 0xd4, 0x7c, 0xd5, 0x85, 0xdb, 0x74, 0x0a,
+    0xf2, 0x0f, 0x10, 0x05, 0x10, 0x00, 0x00, 0x00, 0xff, 0xd0, 0x89, 0xd8,
+    0x48, 0x83, 0xc4, 0x28, 0x5b, 0x5d, 0xc3, 0x66, 0x0f, 0x1f, 0x04, 0x00,
+};
+
+// a function with a frame and a conditional branch, little endian
+const uint8_t arm_code[] = {
+    0x00, 0x48, 0x2d, 0xe9, 0x04, 0xb0, 0x8d, 0xe2, 0x08, 0xd0, 0x4d, 0xe2,
+    0x08, 0x00, 0x0b, 0xe5, 0x08, 0x30, 0x1b, 0xe5, 0x00, 0x00, 0x53, 0xe3,
+    0x02, 0x00, 0x00, 0x0a, 0x01, 0x30, 0x83, 0xe2, 0x03, 0x00, 0xa0, 0xe1,
+    0x04, 0xd0, 0x4b, 0xe2, 0x00, 0x88, 0xbd, 0xe8, 0x1e, 0xff, 0x2f, 0xe1,
+};
+
+// the same function for MIPS, big endian, with delay slots
+const uint8_t mips_code[] = {
+    0x27, 0xbd, 0xff, 0xe0, 0xaf, 0xbf, 0x00, 0x1c, 0xaf, 0xbe, 0x00, 0x18,
+    0x03, 0xa0, 0xf0, 0x25, 0xaf, 0xc4, 0x00, 0x20, 0x8f, 0xc2, 0x00, 0x20,
+    0x10, 0x40, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x24, 0x42, 0x00, 0x01,
+    0x03, 0xc0, 0xe8, 0x25, 0x8f, 0xbf, 0x00, 0x1c, 0x8f, 0xbe, 0x00, 0x18,
+    0x27, 0xbd, 0x00, 0x20, 0x03, 0xe0, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00,
+};
+
+struct stream {
+    std::string triple;
+    std::string name;
+    std::vector<char> data;
+};
+
+template <std::size_t N>
+stream synthetic(const char *triple, const uint8_t (&code)[N]) {
+    stream s = {triple, triple, {}};
+    s.data.reserve(stream_size);
+    while (s.data.size() + N <= stream_size)
+        s.data.insert(s.data.end(), code, code + N);
+    return s;
+}
+
+bool recorded(const std::string &arg, stream &s) {
+    auto eq = arg.find('=');
+    if (eq == std::string::npos)
+        return false;
+    s.triple = arg.substr(0, eq);
+    s.name = arg.substr(eq + 1);
+    std::ifstream file(s.name, std::ios::binary);
+    if (!file)
+        return false;
+    s.data.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+    return !s.data.empty();
+}
+
+enum mode { step, sweep, stop_on_branch };
+
+const char *mode_name(mode m) {
+    switch (m) {
+    case step: return "step";
+    case sweep: return "sweep";
+    default: return "branch";
+    }
+}
+
+struct config {
+    mode m;
+    bool asms;
+    bool preds;
+};
+
+void setup(bap_disasm_type d, const config &c) {
+    bap_disasm_insns_clear(d);
+    bap_disasm_store_asm_strings(d, c.asms);
+    bap_disasm_store_predicates(d, c.preds);
+    bap_disasm_predicates_clear(d);
+    switch (c.m) {
+    case step:
+        bap_disasm_predicates_push(d, is_true);
+        break;
+    case stop_on_branch:
+        bap_disasm_predicates_push(d, is_branch);
+        bap_disasm_predicates_push(d, is_invalid);
+        break;
+    case sweep:
+        break;
+    }
+}
+
+// disassembles the whole stream and returns the number of decoded
+// instructions.
+int64_t disassemble(bap_disasm_type d, const stream &s) {
+    int size = s.data.size();
+    int64_t total = 0;
+    bap_disasm_set_memory(d, base_address, s.data.data(), 0, size);
+    for (;;) {
+        bap_disasm_insns_clear(d);
+        bap_disasm_run(d);
+        int n = bap_disasm_insns_size(d);
+        int last = n - 1;
+        if (bap_disasm_insn_size(d, last) == 0)
+            return total + last;
+        total += n;
+        if (bap_disasm_offset(d) >= size)
+            return total;
+    }
+}
+
+struct result {
+    int64_t insns;
+    double seconds;
+};
+
+result measure(bap_disasm_type d, const stream &s, const config &c,
+               double min_time) {
+    result r = {0, 0.0};
+    setup(d, c);
+    disassemble(d, s);       // warm up
+    auto start = clock::now();
+    do {
+        r.insns += disassemble(d, s);
+        r.seconds = std::chrono::duration<double>(clock::now() - start).count();
+    } while (r.seconds < min_time);
+    return r;
+}
+
+void report(const stream &s, const config &c, const result &r) {
+    std::string name = s.name + "/" + mode_name(c.m);
+    if (c.asms) name += "/asm";
+    if (c.preds) name += "/preds";
+    double ns = r.seconds * 1e9 / r.insns;
+    double rate = r.insns / r.seconds / 1e6;
+    std::printf("%-40s %10.1f ns %10.2f M/s %12lld\n",
+                name.c_str(), ns, rate, (long long)r.insns);
+}
+
+void run(const stream &s, double min_time) {
+    bap_disasm_type d = bap_disasm_create("llvm", s.triple.c_str(), "", 0);
+    if (d < 0) {
+        std::fprintf(stderr, "%s: failed to create a disassembler: %d\n",
+                     s.triple.c_str(), d);
+        return;
+    }
+    for (mode m : {step, sweep, stop_on_branch})
+        for (bool asms : {false, true})
+            for (bool preds : {false, true}) {
+                config c = {m, asms, preds};
+                report(s, c, measure(d, s, c, min_time));
+            }
+    bap_disasm_delete(d);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    double min_time = 0.5;
+    std::vector<stream> streams = {
+        synthetic("x86_64", x86_64_code),
+        synthetic("arm", arm_code),
+        synthetic("mips", mips_code),
+    };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        stream s;
+        if (arg.compare(0, 11, "--min-time=") == 0) {
+            min_time = std::atof(arg.c_str() + 11);
+        } else if (recorded(arg, s)) {
+            streams.push_back(s);
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--min-time=SECONDS] [TRIPLE=FILE]...\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    if (disasm_llvm_init() < 0) {
+        std::fprintf(stderr, "failed to initialize the llvm backend\n");
+        return 1;
+    }
+
+    std::printf("%-40s %13s %14s %12s\n",
+                "Benchmark", "Time/insn", "Insns/s", "Insns");
+    for (const stream &s : streams)
+        run(s, min_time);
+    return 0;
+}
@@ -0,0 +1,45 @@
+open Core.Std
+open Core_bench.Std
+open Bap.Std
+
+(* A synthetic 10 MB x86_64 text section, filled with copies of a
+   small leaf function, that are linked with direct calls, so that
+   the recursive disassembler discovers them strictly in the address
+   order. Either every function is a root, or only the first one is,
+   and the rest are found by following the calls. *)
+
+let func = String.concat [
+    "\x55";                             (* push rbp *)
+    "\x48\x89\xe5";                     (* mov rbp, rsp *)
+    "\x89\x7d\xfc";                     (* mov [rbp-4], edi *)
+    "\x8b\x45\xfc";                     (* mov eax, [rbp-4] *)
+    "\x83\xc0\x01";                     (* add eax, 1 *)
+    "\x5d";                             (* pop rbp *)
+    "\xe8\x01\x00\x00\x00";             (* call next *)
+    "\xc3";                             (* ret *)
+  ]
+
+let size = 10 * 1024 * 1024
+let copies = size / String.length func
+let base = Addr.of_int64 ~width:64 0x400000L
+
+let text =
+  let code = String.concat (List.init copies ~f:(fun _ -> func)) in
+  Memory.create LittleEndian base (Bigstring.of_string code) |> ok_exn
+
+let roots n =
+  Seq.init n ~f:(fun i -> Addr.nsucc base (i * String.length func))
+
+let recursive n =
+  let rooter = Rooter.create (roots n) in
+  Staged.stage (fun () ->
+      match Disasm_expert.Recursive.run ~rooter `x86_64 text with
+      | Ok _ -> ()
+      | Error err -> Error.raise err)
+
+let test = Bench.Test.create_group ~name:"recursive" [
+    Bench.Test.create_indexed ~name:"Recursive.run_10MB_roots"
+      ~args:[1; copies] recursive;
+  ]
+
+let tests = [test]
@@ -0,0 +1,86 @@
+open Core.Std
+open Core_bench.Std
+open Bap.Std
+
+(* A synthetic PE32 image with a single code section and [n] function
+   symbols, evenly spread over the section. The layout is:
+
+   0x000  DOS header (only the magic and the PE header offset)
+   0x040  PE signature and COFF file header
+   0x058  PE32 optional header
+   0x138  section table
+   0x200  section data
+   ...    symbol table, followed by an empty string table *)
+
+let pe_offset = 0x40
+let opt_header = pe_offset + 4 + 20
+let opt_header_size = 224
+let sections = opt_header + opt_header_size
+let text = 0x200
+let image_base = 0x400000
+let text_addr = 0x1000
+let symbol_size = 18
+let symbol_stride = 16
+
+let set16 buf pos x =
+  Bytes.set buf pos (Char.of_int_exn (x land 0xff));
+  Bytes.set buf (pos+1) (Char.of_int_exn ((x lsr 8) land 0xff))
+
+let set32 buf pos x =
+  set16 buf pos (x land 0xffff);
+  set16 buf (pos+2) ((x lsr 16) land 0xffff)
+
+let setstr buf pos s = Bytes.blit_string s 0 buf pos (String.length s)
+
+let coff_image n =
+  let text_size = n * symbol_stride in
+  let symtab = text + text_size in
+  let size = symtab + n * symbol_size + 4 in
+  let buf = Bytes.make size '\x00' in
+  setstr buf 0 "MZ";
+  set32 buf 0x3c pe_offset;
+  setstr buf pe_offset "PE\x00\x00";
+  let coff = pe_offset + 4 in
+  set16 buf coff 0x14c;                 (* i386 *)
+  set16 buf (coff+2) 1;                 (* number of sections *)
+  set32 buf (coff+8) symtab;
+  set32 buf (coff+12) n;
+  set16 buf (coff+16) opt_header_size;
+  set16 buf (coff+18) 0x102;            (* executable, 32 bit *)
+  set16 buf opt_header 0x10b;           (* PE32 magic *)
+  set32 buf (opt_header+16) text_addr;  (* entry point *)
+  set32 buf (opt_header+20) text_addr;  (* base of code *)
+  set32 buf (opt_header+28) image_base;
+  set32 buf (opt_header+32) 0x1000;     (* section alignment *)
+  set32 buf (opt_header+36) 0x200;      (* file alignment *)
+  set32 buf (opt_header+92) 16;         (* number of data directories *)
+  setstr buf sections ".text";
+  set32 buf (sections+8) text_size;
+  set32 buf (sections+12) text_addr;
+  set32 buf (sections+16) text_size;
+  set32 buf (sections+20) text;
+  set32 buf (sections+36) 0x60000020;   (* code, execute, read *)
+  for i = 0 to n - 1 do
+    let sym = symtab + i * symbol_size in
+    setstr buf sym (sprintf "f%07d" i);
+    set32 buf (sym+8) (i * symbol_stride);
+    set16 buf (sym+12) 1;               (* section number *)
+    set16 buf (sym+14) 0x20;            (* function *)
+    Bytes.set buf (sym+16) '\x02';      (* external *)
+  done;
+  set32 buf (symtab + n * symbol_size) 4;
+  Bigstring.of_string (Bytes.to_string buf)
+
+let load_coff n =
+  let data = coff_image n in
+  Staged.stage (fun () ->
+      match Image.of_bigstring ~backend:"llvm" data with
+      | Ok _ -> ()
+      | Error err -> Error.raise err)
+
+let test = Bench.Test.create_group ~name:"loader" [
+    Bench.Test.create_indexed ~name:"Image.of_bigstring_coff"
+      ~args:[1_000; 10_000; 50_000] load_coff;
+  ]
+
+let tests = [test]
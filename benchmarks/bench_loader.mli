@@ -0,0 +1,3 @@
+open Core_bench.Std
+
+val tests : Bench.Test.t list
@@ -1,11 +1,16 @@
 open Core.Std
 open Core_bench.Std
 open Bap.Std
+open Bap_plugins.Std
 
 let benchmarks = Bench.make_command @@ List.concat [
     Bench_dom.tests;
     Bench_image.tests;
+    Bench_loader.tests;
+    Bench_disasm_rec.tests;
   ]
 
 
-let () = Command.run benchmarks
+let () =
+  Plugins.load () |> ignore;
+  Command.run benchmarks
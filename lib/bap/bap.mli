@@ -1782,6 +1782,79 @@ module Std : sig
         variables [x] and [y] the [same x y] is [true] iff [equal
         (base x) (base y)] *)
     val same : t -> t -> bool
+
+    (** [id var] is a dense integer identifier of [var].
+
+        Variables are interned, i.e., each distinct variable is
+        created only once, and is assigned a small identifier, that
+        is not used by another live variable. Two variables are
+        equal iff their identifiers are equal, and variables are
+        compared and hashed by their identifiers. The table of
+        variables is weak, so when a variable is collected, its
+        identifier is reused. Identifiers are local to a process,
+        they are not serialized, and the order of variables is not
+        the lexicographical order of their names. A variable, that
+        was read with the [Marshal] module, e.g., from a project
+        cache, is interned again on the first use of its identifier.  *)
+    val id : t -> int
+
+    (** Sets of variables, represented as bit vectors indexed by
+        variable identifiers.
+
+        A set keeps only the words between its smallest and its
+        largest identifier, and all operations are linear in this
+        span, divided by the word size, so set operations, e.g.,
+        [union] or [diff], are much faster than for [Var.Set], if
+        sets are dense, as they usually are in a data flow analysis
+        of a subroutine.  Sets are persistent.
+
+        A set doesn't reference its members, so a variable, that was
+        added to a set, is never collected, and its identifier is
+        never reused. *)
+    module Bitset : sig
+      type var = t
+      type t
+      val empty : t
+      val singleton : var -> t
+      val is_empty : t -> bool
+      val mem : t -> var -> bool
+      val add : t -> var -> t
+      val remove : t -> var -> t
+      val union : t -> t -> t
+      val inter : t -> t -> t
+      val diff : t -> t -> t
+      val equal : t -> t -> bool
+      val subset : t -> t -> bool
+      val length : t -> int
+
+      (** [fold set ~init ~f] folds over variables in the order of
+          their identifiers *)
+      val fold : t -> init:'a -> f:('a -> var -> 'a) -> 'a
+      val iter : t -> f:(var -> unit) -> unit
+      val elements : t -> var list
+
+      (** [of_list vars] and [of_set vars] build a set in one pass,
+          without intermediate sets, unlike a sequence of [add] *)
+      val of_list : var list -> t
+      val to_set : t -> Set.t
+      val of_set : Set.t -> t
+    end
+
+    (** Mutable maps from variables, represented as arrays indexed by
+        variable identifiers. Lookup and update take constant time.
+        A map references its keys. *)
+    module Array_map : sig
+      type var = t
+      type 'a t
+      val create : unit -> 'a t
+      val copy : 'a t -> 'a t
+      val find : 'a t -> var -> 'a option
+      val mem : 'a t -> var -> bool
+      val set : 'a t -> key:var -> data:'a -> unit
+      val remove : 'a t -> var -> unit
+      val iteri : 'a t -> f:(key:var -> data:'a -> unit) -> unit
+      val fold : 'a t -> init:'b -> f:(key:var -> data:'a -> 'b -> 'b) -> 'b
+    end
   end
 
 
@@ -2091,6 +2164,37 @@ module Std : sig
           data structure, and provides logarithmic lookup and
           update method. *)
       class sparse : storage
+
+      (** paged storage keeps bytes in 4 KiB pages, and provides
+          constant time lookup and update methods, that do not
+          allocate, if a page is already present. Unlike other
+          storages it is mutable, i.e., [save] modifies the storage
+          and returns it. Use the [copy] method to fork a storage, a
+          copy shares all pages with the original, that are copied
+          on a first write, either by the copy or by the original.
+          All paged storages can be forked at once with
+          {!Context.snapshot}.
+
+          As in other storages, addresses of different widths are
+          different, even if their values are equal. Pages hold
+          addresses of a single width, the width of the first stored
+          byte. Words, that are not bytes, and words at addresses of
+          other widths are stored in a balanced tree.
+
+          To use it with an interpreter, override the [empty] method,
+          e.g.,
+
+          {[
+            class ['a] fast = object
+              inherit ['a] bili
+              method! empty = (new Bil.Storage.paged :> Bil.storage)
+            end
+          ]}
+      *)
+      class paged : object('s)
+        inherit storage
+        method copy : 's
+      end
     end
 
 
@@ -2251,6 +2355,54 @@ module Std : sig
       method update : var -> Bil.result -> 's
       method bindings : (var * Bil.result) Sequence.t
     end
+
+    (** A mutable context, that keeps variables in a flat array.
+
+        Variables are mapped to dense slots in the order, in which
+        they are first bound, so lookup and update have constant
+        time, and the size of a context depends only on the number
+        of variables bound in it and in its copies. The [update] method modifies
+        the context and returns it, so a context, that must be
+        preserved, should be copied with the [copy] method, or
+        preserved with {!snapshot}.
+
+        A flat context can replace the base context in any
+        interpreter context, e.g.,
+
+        {[
+          class context = object
+            inherit Bili.context
+            inherit! Context.flat
+          end
+        ]}
+    *)
+    class flat : object('s)
+      inherit t
+      method copy : 's
+    end
+
+    (** [snapshot ()] preserves the current state of all flat
+        contexts and paged storages in O(1).
+
+        After a snapshot an existing mutable context or storage is no
+        longer modified in place. Instead, the first update copies it,
+        and the copy is modified and returned, so that all references
+        captured before the snapshot still see the old state. Pages
+        of storages are shared by the copies until they are written.
+
+        The snapshot itself is O(1), but the first update of each
+        context or storage after it is not: a flat context copies
+        its array of registers, that has a slot for each variable
+        bound in it, and a paged storage copies its table of pages
+        (but not the pages), so the cost is O(regs) and O(pages)
+        respectively. Further updates, until the next snapshot, are
+        done in place.
+
+        Take a snapshot before keeping a reference to a state, e.g.,
+        at a branch point of a path exploration, and then backtrack
+        to it later. Taking a snapshot at every step makes every
+        update a copy. *)
+    val snapshot : unit -> unit
   end
 
   module Type_error : sig
@@ -2522,6 +2674,73 @@ module Std : sig
   (** BIL {{!Bili}interpreter} *)
   class ['a] bili : ['a] Bili.t
 
+  (** Compiled BIL evaluator.
+
+      [Bilc] compiles a BIL program once into a tree of OCaml
+      closures, that operate on a mutable register file, where each
+      variable has its own slot. Programs, compiled for the same
+      register file, share it, so a long trace of instructions may be
+      compiled instruction by instruction, and each instruction can
+      then be evaluated repeatedly without any overhead of tree
+      walking, method dispatching, or state passing.
+
+      The semantics is the same as of the {!bili} interpreter with
+      the default behavior, except that values are not tagged with
+      identifiers. Unlike [bili], the evaluator can't be extended,
+      so if an analysis needs to override evaluation methods, then it
+      should use [bili].
+
+      {v
+      let x = Var.create "x" reg32_t;;
+      let s = Bilc.create ();;
+      let p = Bilc.compile s Bil.[x := int (Word.of_int32 1l)];;
+      Bilc.run p;;
+      Bilc.lookup s x;;
+      - : Bil.value = 0x1:32
+      v}
+  *)
+  module Bilc : sig
+
+    (** a register file  *)
+    type t
+
+    (** a program, compiled for a particular register file  *)
+    type program
+
+    (** [create ()] creates an empty register file  *)
+    val create : unit -> t
+
+    (** [compile regs bil] compiles [bil] for the register file
+        [regs]. *)
+    val compile : t -> stmt list -> program
+
+    (** [compile_exp regs exp] compiles an expression, the returned
+        function evaluates it under the current state of [regs]. *)
+    val compile_exp : t -> exp -> (unit -> Bil.value)
+
+    (** [run program] evaluates the [program]  *)
+    val run : program -> unit
+
+    (** [eval bil regs] compiles and evaluates [bil] once  *)
+    val eval : stmt list -> t -> unit
+
+    (** [lookup regs var] is the value of [var], or [Bot] if it is
+        undefined.  *)
+    val lookup : t -> var -> Bil.value
+
+    (** [update regs var x] sets the value of [var] to [x]  *)
+    val update : t -> var -> Bil.value -> unit
+
+    (** [pc regs] is the destination of the last taken jump  *)
+    val pc : t -> Bil.value
+
+    (** [with_pc regs x] sets the program counter to [x]  *)
+    val with_pc : t -> Bil.value -> unit
+
+    (** [bindings regs] enumerates all variables with defined values *)
+    val bindings : t -> (var * Bil.value) seq
+  end
+
 
   (** [Regular] interface for BIL expressions *)
   module Exp : sig
@@ -4158,12 +4377,19 @@ module Std : sig
         this information messages can be considered as warnings. *)
     type result = (t * Error.t list) Or_error.t
 
-    (** [create ?backend filename] creates an image of the file specified
-        specified by the [filename]. If [backend] is equal to "auto", then
-        all backends are tried in order. If only one backend can read this
-        file (i.e., there is no ambiguity), then image is returned. If
-        [backend] is not specifed, then the LLVM backend is used. *)
-    val create : ?backend:string -> path -> result
+    (** [create ?backend ?mmap filename] creates an image of the file
+        specified specified by the [filename]. If [backend] is equal
+        to "auto", then all backends are tried in order. If only one
+        backend can read this file (i.e., there is no ambiguity), then
+        image is returned. If [backend] is not specifed, then the LLVM
+        backend is used.
+
+        If [mmap] is [true] (the default), then the file is mapped
+        into memory rather than read, so that the backend and the
+        image memory share the same pages and the file is never
+        copied. Pass [~mmap:false] to read the file into the heap,
+        e.g., if the file may change while the image is alive. *)
+    val create : ?backend:string -> ?mmap:bool -> path -> result
 
     (** [of_string ?backend ~data] creates an image from the specified
         [data]. See {!create} for [backend] parameter. *)
@@ -4543,6 +4769,11 @@ module Std : sig
           silent backend set it [0]. This is a default value. Example:
 
           [with_disasm ~debug_level:3 ~backend:"llvm" "x86_64" ~f:process]
+
+          Disassemblers share process-wide tables of interned names,
+          that are not synchronized, so disassemblers may be used by
+          only one thread at a time. Processes, forked by the
+          parallel disassembler, get their own copies.
       *)
       val with_disasm :
         ?debug_level:int -> ?cpu:string -> backend:string -> string ->
@@ -4691,6 +4922,49 @@ module Std : sig
         include Trie with type key := key
       end
 
+      (** Statistics of the disassembler backend.
+
+          When enabled, every disassembler created afterwards counts
+          decoded instructions, predicate evaluations and rendered
+          assembly strings, and measures time spent in the backend. The
+          statistics of a disassembler are added to the totals when it is
+          closed. Statistics of worker processes of a parallel
+          disassembly are added to the totals of their parent. *)
+      module Stats : sig
+        type t = {
+          insns : int;             (** instructions decoded *)
+          invalid : int;           (** invalid instructions *)
+          preds : int;             (** predicates evaluated by the backend *)
+          asms : int;              (** assembly strings rendered *)
+          decode_ns : int;         (** nanoseconds spent in decoding *)
+          print_ns : int;          (** nanoseconds spent in rendering *)
+          cycles : int;            (** CPU cycles spent in the backend *)
+          cache_misses : int;      (** CPU cache misses in the backend *)
+        } [@@deriving sexp_of]
+
+        (** [enable ?counters ()] enables statistics. If [counters] is
+            [true] (defaults to [false]), then CPU cycles and cache misses
+            are read from hardware performance counters, when they are
+            available, otherwise they are zero.  *)
+        val enable : ?counters:bool -> unit -> unit
+
+        (** [disable ()] disables statistics for new disassemblers  *)
+        val disable : unit -> unit
+
+        (** [total ()] returns the totals of all closed disassemblers  *)
+        val total : unit -> t
+
+        (** [reset ()] resets the totals  *)
+        val reset : unit -> unit
+
+        (** [account stats] adds [stats] to the totals, e.g., the totals
+            of another process  *)
+        val account : t -> unit
+
+        (** [pp ppf stats] prints a human readable report  *)
+        val pp : Format.formatter -> t -> unit
+      end
+
       val available_backends : unit -> string list
     end
 
@@ -4701,11 +4975,34 @@ module Std : sig
           disassembly on the specified memory [mem] *)
       val sweep : arch -> mem -> t Or_error.t
 
+      (** [Linear.boundaries arch mem] performs a linear sweep of
+          [mem] that only finds instruction boundaries, and returns
+          a memory region for each instruction. On x86 and x86-64
+          the boundaries are found by an instruction length decoder,
+          that is much faster than the disassembler, on other
+          architectures the disassembler is used. An invalid
+          instruction occupies one byte. An incomplete instruction
+          at the end of [mem] is not included. *)
+      val boundaries : arch -> mem -> mem list Or_error.t
+
+      (** [Linear.decode arch mems] disassembles and lifts
+          instructions occupying [mems], usually only those of
+          [boundaries arch mem] that are of interest.  *)
+      val decode : arch -> mem list -> t Or_error.t
+
       module With_exn : sig
         (** [Linear.With_exn.sweep] same as
             [Linear_sweep.memory], but raises an exception, instead of
             returning [Or_error] monad *)
         val sweep : arch -> mem -> t
+
+        (** [Linear.With_exn.boundaries] same as [Linear.boundaries],
+            but raises an exception on error.  *)
+        val boundaries : arch -> mem -> mem list
+
+        (** [Linear.With_exn.decode] same as [Linear.decode], but
+            raises an exception on error.  *)
+        val decode : arch -> mem list -> t
       end
     end
 
@@ -4725,10 +5022,47 @@ module Std : sig
         | `Failed_to_lift of mem * Basic.full_insn * Error.t
       ] [@@deriving sexp_of]
 
+      (** [run ?backend ?brancher ?rooter ?jobs ?lifted_capacity arch mem]
+          disassembles memory [mem] starting from roots, provided by
+          [rooter]. If [jobs] is greater than one (defaults to one),
+          then the roots are split into [jobs] clusters, and each
+          cluster is explored by a separate process. Up to
+          [lifted_capacity] instructions (defaults to [0x40000]),
+          lifted during the exploration, are kept for building the
+          blocks, the rest are lifted again.  *)
       val run :
         ?backend:string ->
         ?brancher:brancher ->
-        ?rooter:rooter -> arch -> mem -> t Or_error.t
+        ?rooter:rooter ->
+        ?jobs:int ->
+        ?lifted_capacity:int -> arch -> mem -> t Or_error.t
+
+      (** [run_all ?backend ?brancher ?rooter ?jobs ?lifted_capacity arch mems]
+          disassembles each memory region in [mems] as {!run} does,
+          and returns the results in the same order. If [jobs] is
+          greater than one (defaults to one), then the regions are
+          explored concurrently by up to [jobs] processes.  *)
+      val run_all :
+        ?backend:string ->
+        ?brancher:brancher ->
+        ?rooter:rooter ->
+        ?jobs:int ->
+        ?lifted_capacity:int -> arch -> mem list -> t list Or_error.t
+
+      (** [update ?backend ?brancher arch t mem changes] updates the
+          result [t] of a previous disassembly after memory regions
+          [changes] were patched. [mem] is the new contents of the
+          memory disassembled by [t], spanning the same addresses.
+
+          Blocks that intersect [changes] are disassembled again,
+          together with code that becomes reachable from them. All
+          other blocks are reused if their extent hasn't changed, so
+          the cost is proportional to the size of the change, rather
+          than to the size of [mem]. *)
+      val update :
+        ?backend:string ->
+        ?brancher:brancher ->
+        arch -> t -> mem -> mem list -> t Or_error.t
 
       val cfg : t -> cfg
 
@@ -5038,6 +5372,15 @@ module Std : sig
       ?brancher:brancher ->
       ?rooter:rooter -> arch -> mem -> t Or_error.t
 
+    (** [of_mems ?jobs arch mems] disassembles each memory region in
+        [mems] as {!of_mem} does, and merges the results. If [jobs] is
+        greater than one (defaults to one), then the regions are
+        explored concurrently by up to [jobs] processes.  *)
+    val of_mems :
+      ?backend:string ->
+      ?brancher:brancher ->
+      ?rooter:rooter -> ?jobs:int -> arch -> mem list -> t Or_error.t
+
     (** [disassemble_image image] disassemble a given image.
         Will take executable segments of the image and disassemble it,
         applying [disassemble] function. If no roots are specified, then
@@ -5057,6 +5400,8 @@ module Std : sig
 
     module With_exn : sig
       val of_mem   : ?backend:string -> ?brancher:brancher -> ?rooter:rooter -> arch -> mem -> t
+      val of_mems  : ?backend:string -> ?brancher:brancher -> ?rooter:rooter ->
+        ?jobs:int -> arch -> mem list -> t
       val of_image : ?backend:string -> ?brancher:brancher -> ?rooter:rooter -> image -> t
       val of_file  : ?backend:string -> ?brancher:brancher ->
         ?rooter:rooter -> ?loader:string -> string -> t
@@ -6834,7 +7179,14 @@ module Std : sig
       type t = input
       val file : ?loader:string -> filename:string -> t
       val binary : ?base:addr -> arch -> filename:string -> t
-      val create : arch -> string -> code:value memmap -> data: value memmap -> t
+
+      (** [create ?jobs arch filename ~code ~data] creates an input
+          from the given memory. The [code] regions are disassembled
+          by up to [jobs] processes (defaults to one), which pays off
+          when there are many independent regions, e.g., members of
+          an archive.  *)
+      val create :
+        ?jobs:int -> arch -> string -> code:value memmap -> data: value memmap -> t
       val register_loader : string -> (string -> t) -> unit
       val available_loaders : unit -> string list
     end
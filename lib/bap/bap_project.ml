@@ -52,12 +52,13 @@ module Input = struct
     data : value memmap;
     code : value memmap;
     file : string;
+    jobs : int;
   }
 
   type t = unit -> result
 
-  let create arch file ~code ~data () = {
-    arch; file; code; data
+  let create ?(jobs=1) arch file ~code ~data () = {
+    arch; file; code; data; jobs
   }
 
   let loaders = String.Table.create ()
@@ -75,6 +76,7 @@ module Input = struct
     data = Image.memory img;
     code = filter_code (Image.memory img);
     file;
+    jobs = 1;
   }
 
   let of_image ?loader filename =
@@ -102,7 +104,7 @@ module Input = struct
     let mem = Memory.create (Arch.endian arch) base big |> ok_exn in
     let section = Value.create Image.section "bap.user" in
     let data = Memmap.add Memmap.empty mem section in
-    {arch; data; code = data; file = filename}
+    {arch; data; code = data; file = filename; jobs = 1}
 
   let available_loaders () =
     Hashtbl.keys loaders @ Image.available_backends ()
@@ -211,7 +213,7 @@ let create_exn
   let cfg     = MVar.create ~compare:Cfg.compare Cfg.empty in
   let symtab  = MVar.create ~compare:Symtab.compare Symtab.empty in
   let program = MVar.create ~compare:Program.compare (Program.create ()) in
-  let {Input.arch; data; code; file} = read () in
+  let {Input.arch; data; code; file; jobs} = read () in
   Signal.send Info.got_file file;
   Signal.send Info.got_arch arch;
   Signal.send Info.got_data data;
@@ -221,16 +223,12 @@ let create_exn
     let brancher = MVar.read mbrancher
     and rooter   = MVar.read mrooter in
     let disassemble () =
-      let run mem =
-        let dis =
-          Disasm.With_exn.of_mem ?backend ?brancher ?rooter arch mem in
-        Disasm.errors dis |>
-        List.iter ~f:(fun e -> warning "%a" pp_disasm_error e);
-        Disasm.cfg dis in
-      Memmap.to_sequence code |>
-      Seq.fold ~init:Cfg.empty ~f:(fun cfg (mem,_) ->
-          Graphlib.union (module Cfg) cfg (run mem)) |>
-      MVar.write cfg  in
+      let mems = Memmap.to_sequence code |> Seq.map ~f:fst |> Seq.to_list in
+      let dis =
+        Disasm.With_exn.of_mems ?backend ?brancher ?rooter ~jobs arch mems in
+      Disasm.errors dis |>
+      List.iter ~f:(fun e -> warning "%a" pp_disasm_error e);
+      MVar.write cfg (Disasm.cfg dis) in
     if updated then disassemble ();
     let is_cfg_updated = phase_triggered Info.got_cfg cfg in
     let g = MVar.read cfg in
@@ -80,6 +80,10 @@ module Disasm = struct
     let merge = Graphlib.union (module Rec.Cfg) in
     {cfg = merge d1.cfg d2.cfg; err = d1.err @ d2.err}
 
+  let of_mems ?backend ?brancher ?rooter ?jobs arch mems =
+    Rec.run_all ?backend ?brancher ?rooter ?jobs arch mems >>|
+    List.fold ~init:empty ~f:(fun dis r -> merge dis (of_rec r))
+
   let of_image ?backend ?brancher ?rooter image =
     let arch = Image.arch image in
     let rooter =
@@ -98,6 +102,8 @@ module Disasm = struct
   module With_exn = struct
     let of_mem ?backend ?brancher ?rooter arch mem =
       of_mem ?backend ?brancher ?rooter arch mem |> ok_exn
+    let of_mems ?backend ?brancher ?rooter ?jobs arch mems =
+      of_mems ?backend ?brancher ?rooter ?jobs arch mems |> ok_exn
     let of_file ?backend ?brancher ?rooter ?loader filename =
       of_file ?backend ?brancher ?rooter ?loader filename |> ok_exn
     let of_image ?backend ?brancher ?rooter image =
@@ -17,11 +17,13 @@ module Disasm : sig
   type 'a disassembler = ?backend:string -> ?brancher:brancher -> ?rooter:rooter -> 'a
   val create : cfg -> disasm
   val of_mem : (arch -> mem -> disasm Or_error.t) disassembler
+  val of_mems : (?jobs:int -> arch -> mem list -> disasm Or_error.t) disassembler
   val of_image : (image -> disasm Or_error.t) disassembler
   val of_file : (?loader:string -> string -> disasm Or_error.t) disassembler
 
   module With_exn : sig
     val of_mem : (arch -> mem -> disasm) disassembler
+    val of_mems : (?jobs:int -> arch -> mem list -> disasm) disassembler
     val of_image : (image -> disasm) disassembler
     val of_file : (?loader:string -> string -> disasm) disassembler
   end
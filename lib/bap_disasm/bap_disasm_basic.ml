@@ -52,10 +52,22 @@ module Table = struct
     cache : string Int.Table.t;
   }
 
-  let create data = {
+  (* Name tables of a target are the same for all its disassemblers,
+     so names, once interned, are shared by all disassemblers of the
+     process, that are created for the same backend and target. Only
+     the cache is shared, the data is always taken from a disassembler,
+     as it is valid only while the disassembler is alive.
+
+     The tables are not synchronized, so disassemblers must not be
+     used from several threads at once. The parallel disassembler
+     runs its workers in separate processes, each with its own
+     copy of the tables. *)
+  let caches : string Int.Table.t String.Table.t = String.Table.create ()
+
+  let create ~target data = {
     data;
     size = Bigstring.length data;
-    cache = Int.Table.create ();
+    cache = Hashtbl.find_or_add caches target ~default:Int.Table.create;
   }
 
   let lookup t pos =
@@ -71,10 +83,108 @@ module Table = struct
             dst)
 end
 
+(** Instruction queue, retrieved from the disassembler in one call.
+    See disasm.h for the layout. *)
+module Batch = struct
+  module Array1 = Bigarray.Array1
+
+  type t = {mutable data : C.batch}
+
+  let header = 2
+  let insn_fields = 6
+
+  let alloc size : C.batch =
+    Array1.create Bigarray.int64 Bigarray.c_layout size
+
+  let create () = {data = alloc 1024}
+
+  (** [run t dd] runs the disassembler and returns the queue *)
+  let run t dd =
+    let size = C.run_batch dd t.data in
+    if size > Array1.dim t.data then begin
+      t.data <- alloc (max size (2 * Array1.dim t.data));
+      ignore (C.batch_copy dd t.data : int)
+    end;
+    t.data
+
+  (* all words, except operand values, are small integers written by
+     the disassembler, so the conversion can't overflow, and unlike
+     [to_int_exn] it doesn't box the word. *)
+  let int (b : C.batch) i = Int64.to_int_trunc b.{i}
+
+  let length b = int b 0
+  let opers_total b = int b 1
+  let field b k i = int b (header + k * length b + i)
+
+  let code b insn = field b 0 insn
+  let name b insn = field b 1 insn
+  let offset b insn = field b 2 insn
+  let size b insn = field b 3 insn
+  let preds b insn = field b 4 insn
+  let opers b insn = field b 5 insn
+  let ops_size b insn = opers b (insn + 1) - opers b insn
+  let is_invalid b insn = code b insn = 0
+
+
+  (** [op_pos b insn] is the position of the first operand of
+      [insn] in the operand slab, operands of an instruction are
+      consecutive, so the position of the operand [n] is [pos + n].
+      The position is computed once per instruction, and operand
+      fields are accessed by it.  *)
+  let op_pos b insn =
+    header + insn_fields * length b + 1 + opers b insn
+
+  let op_type b pos = match int b pos with
+    | 0 -> C.Reg
+    | 1 -> C.Imm
+    | 2 -> C.Fmm
+    | _ -> C.Insn
+
+  let op_value b pos = b.{pos + opers_total b}
+  let op_name b pos = int b (pos + 2 * opers_total b)
+end
+
+(** Assembly strings of the instruction queue, retrieved from the
+    disassembler arena in one call. See disasm.h for the layout. *)
+module Asms = struct
+  module Array1 = Bigarray.Array1
+
+  type t = {
+    mutable data : Bigstring.t;
+    mutable index : C.offsets;
+  }
+
+  let alloc_index size : C.offsets =
+    Array1.create Bigarray.int32 Bigarray.c_layout size
+
+  let create () = {data = Bigstring.create 4096; index = alloc_index 1024}
+
+  (** [fetch t dd] copies the arena and its index from the disassembler *)
+  let fetch t dd =
+    let size = C.asm_arena_copy dd t.data in
+    if size > Bigstring.length t.data then begin
+      t.data <- Bigstring.create (max size (2 * Bigstring.length t.data));
+      ignore (C.asm_arena_copy dd t.data : int)
+    end;
+    let size = C.asm_index_copy dd t.index in
+    if size > Array1.dim t.index then begin
+      t.index <- alloc_index (max size (2 * Array1.dim t.index));
+      ignore (C.asm_index_copy dd t.index : int)
+    end
+
+  (** [get t insn] is the assembly string of the instruction [insn]  *)
+  let get t insn =
+    let pos = Int32.to_int_exn t.index.{insn} in
+    let len = Int32.to_int_exn t.index.{insn + 1} - pos in
+    Bigstring.To_string.sub t.data ~pos ~len
+end
+
 type dis = {
   dd : int;
   insn_table : Table.t;
   reg_table  : Table.t;
+  batch : Batch.t;
+  asms : Asms.t;
   asm : bool;
   kinds : bool;
   mutable closed : bool;
@@ -87,13 +197,14 @@ let (!!) dis =
 
 module Reg = struct
 
-  let create dis ~insn ~oper : reg =
+  let create dis batch ~pos ~insn ~oper : reg =
     let data =
-      let reg_code = C.insn_op_reg_code !!dis ~insn ~oper in
+      let reg_code =
+        Int64.to_int_trunc (Batch.op_value batch pos) in
       let reg_name =
         if reg_code = 0 then "Nil"
         else
-          let off = C.insn_op_reg_name !!dis ~insn ~oper in
+          let off = Batch.op_name batch pos in
           (Table.lookup dis.reg_table off) in
       {reg_code; reg_name} in
     {insn; oper; data}
@@ -122,11 +233,14 @@ module Imm = struct
   let fits x =
     not(x = Int.max_value || x = Int.min_value)
 
-  let create dis ~insn ~oper =
+  let create batch ~pos ~insn ~oper =
     let data =
-      let imm_small = C.insn_op_imm_small_value !!dis ~insn ~oper in
-      let imm_large = if fits imm_small then None else
-          Some (C.insn_op_imm_value !!dis ~insn ~oper) in
+      let x = Batch.op_value batch pos in
+      let imm_small =
+        if Int64.(x < of_int Int.min_value) then Int.min_value
+        else if Int64.(x > of_int Int.max_value) then Int.max_value
+        else Int64.to_int_trunc x in
+      let imm_large = if fits imm_small then None else Some x in
       {imm_small; imm_large} in
     {insn; oper; data}
 
@@ -168,9 +282,9 @@ end
 
 module Fmm = struct
 
-  let create dis ~insn ~oper = {
+  let create batch ~pos ~insn ~oper = {
     insn; oper;
-    data = C.insn_op_fmm_value !!dis ~insn ~oper
+    data = Int64.float_of_bits (Batch.op_value batch pos)
   }
   let to_float x = x.data
 
@@ -260,6 +374,15 @@ let cpred_of_pred : pred -> C.pred = function
   | `May_store  -> C.May_store
   | `May_load -> C.May_load
 
+(* kinds paired with their bits in a predicates mask *)
+let kind_bits =
+  List.map Kind.all ~f:(fun k ->
+      k, 1 lsl C.pred_index (cpred_of_pred (k :> pred)))
+
+let kinds_of_mask mask =
+  List.filter_map kind_bits ~f:(fun (k,bit) ->
+      Option.some_if (mask land bit <> 0) k)
+
 module Insn = struct
   type ins_info = {
     code : int;
@@ -288,31 +411,29 @@ module Insn = struct
     List.mem ~equal op.kinds x
 
 
-  let create ~asm ~kinds dis ~insn =
-    let code = C.insn_code !!dis ~insn in
+  let create ~asm ~kinds dis batch ~insn =
+    let code = Batch.code batch insn in
     let name =
-      let off = C.insn_name !!dis ~insn in
+      let off = Batch.name batch insn in
       Table.lookup dis.insn_table off in
     let asm =
-      if asm then
+      if dis.asm then Asms.get dis.asms insn
+      else if asm then
         let data = String.create (C.insn_asm_size !!dis ~insn) in
         C.insn_asm_copy !!dis ~insn data;
         data
       else "" in
     let kinds =
-      if kinds then
-        List.filter_map Kind.all ~f:(fun k ->
-            let p = cpred_of_pred (k :> pred) in
-            if C.is_supported !!dis p
-            then Option.some_if (C.insn_satisfies !!dis ~insn p) k
-            else None)
+      if kinds then kinds_of_mask (Batch.preds batch insn)
       else [] in
     let opers =
-      Array.init (C.insn_ops_size !!dis ~insn) ~f:(fun oper ->
-          match C.insn_op_type !!dis ~insn ~oper with
-          | C.Reg -> Op.Reg Reg.(create dis ~insn ~oper)
-          | C.Imm -> Op.Imm Imm.(create dis ~insn ~oper)
-          | C.Fmm -> Op.Fmm Fmm.(create dis ~insn ~oper)
+      let first = Batch.op_pos batch insn in
+      Array.init (Batch.ops_size batch insn) ~f:(fun oper ->
+          let pos = first + oper in
+          match Batch.op_type batch pos with
+          | C.Reg -> Op.Reg Reg.(create dis batch ~pos ~insn ~oper)
+          | C.Imm -> Op.Imm Imm.(create batch ~pos ~insn ~oper)
+          | C.Fmm -> Op.Fmm Fmm.(create batch ~pos ~insn ~oper)
           | C.Insn -> assert false) in
     {code; name; asm; kinds; opers }
 
@@ -384,9 +505,9 @@ let create_state ?(backlog=8) ?(stop_on=[]) ?stopped ?invalid ?hit dis
   insns = [| |] ;
 }
 
-let insn_mem s ~insn : mem =
-  let off = C.insn_offset !!(s.dis) ~insn in
-  let words = C.insn_size !!(s.dis) ~insn in
+let insn_mem s batch ~insn : mem =
+  let off = Batch.offset batch insn in
+  let words = Batch.size batch insn in
   let from = Addr.(Mem.min_addr s.current.mem ++ off) in
   ok_exn (Mem.view s.current.mem ~from ~words)
 
@@ -439,34 +560,34 @@ let addr s = Addr.(Mem.min_addr s.current.mem ++ s.current.off)
 let step s data =
   C.insns_clear !!(s.dis);
   let rec loop s data =
-    C.run !!(s.dis);
+    let batch = Batch.run s.dis.batch !!(s.dis) in
+    if s.dis.asm then Asms.fetch s.dis.asms !!(s.dis);
     let off = C.offset !!(s.dis) in
     let s = update_state s {s.current with off} in
-    let n = C.insns_size !!(s.dis) in
+    let n = Batch.length batch in
     assert (n > 0);
     let insn = n - 1 in
-    let stop = C.insn_size !!(s.dis) ~insn = 0 in
+    let stop = Batch.size batch insn = 0 in
     let n = if stop then max 0 (n - 1) else n in
     let {asm; kinds} = s.dis in
     let insns = Array.init n ~f:(fun insn -> begin
-          let is_valid =
-            not(C.insn_satisfies !!(s.dis) ~insn C.Is_invalid) in
-          insn_mem s ~insn,
+          let is_valid = not(Batch.is_invalid batch insn) in
+          insn_mem s batch ~insn,
           Option.some_if is_valid
-            (Insn.create ~asm ~kinds s.dis ~insn)
+            (Insn.create ~asm ~kinds s.dis batch ~insn)
         end) in
     let s = {s with insns} in
     if stop then match s.stopped with
       | Some f -> f s data
       | None -> s.return data
-    else if C.insn_satisfies !!(s.dis) ~insn C.Is_invalid
+    else if Batch.is_invalid batch insn
     then match s.invalid with
-      | Some f -> f s (insn_mem s ~insn) data
+      | Some f -> f s (insn_mem s batch ~insn) data
       | None -> loop s data
     else match s.hit with
       | Some f -> f s
-                    (insn_mem s ~insn)
-                    (Insn.create ~asm:true ~kinds:true s.dis ~insn)
+                    (insn_mem s batch ~insn)
+                    (Insn.create ~asm:true ~kinds:true s.dis batch ~insn)
                     data
       | None -> s.return data in
   loop s data
@@ -485,16 +606,91 @@ let back s data =
     | x :: xs -> x,xs in
   step { s with current; history} data
 
+module Stats = struct
+  type t = {
+    insns : int;
+    invalid : int;
+    preds : int;
+    asms : int;
+    decode_ns : int;
+    print_ns : int;
+    cycles : int;
+    cache_misses : int;
+  } [@@deriving sexp_of]
+
+  let empty = {
+    insns = 0; invalid = 0; preds = 0; asms = 0;
+    decode_ns = 0; print_ns = 0; cycles = 0; cache_misses = 0;
+  }
+
+  let level = ref 0
+  let totals = ref empty
+
+  let enable ?(counters=false) () = level := if counters then 2 else 1
+  let disable () = level := 0
+  let total () = !totals
+  let reset () = totals := empty
+
+  let add x y = {
+    insns = x.insns + y.insns;
+    invalid = x.invalid + y.invalid;
+    preds = x.preds + y.preds;
+    asms = x.asms + y.asms;
+    decode_ns = x.decode_ns + y.decode_ns;
+    print_ns = x.print_ns + y.print_ns;
+    cycles = x.cycles + y.cycles;
+    cache_misses = x.cache_misses + y.cache_misses;
+  }
+
+  let of_disasm dd = let open C in {
+      insns = stats_get dd Stat_insns;
+      invalid = stats_get dd Stat_invalid;
+      preds = stats_get dd Stat_preds;
+      asms = stats_get dd Stat_asms;
+      decode_ns = stats_get dd Stat_decode_ns;
+      print_ns = stats_get dd Stat_print_ns;
+      cycles = stats_get dd Stat_cycles;
+      cache_misses = stats_get dd Stat_cache_misses;
+    }
+
+  (* called for each disassembler when it is created *)
+  let start dd = if !level > 0 then C.stats_enable dd !level
+
+  (* called for each disassembler when it is closed *)
+  let collect dd = if !level > 0 then totals := add !totals (of_disasm dd)
+
+  let account t = totals := add !totals t
+
+  let pp ppf t =
+    let ms ns = Float.of_int ns /. 1e6 in
+    Format.fprintf ppf
+      "@[<v>instructions decoded:  %d@;\
+       invalid instructions:  %d@;\
+       predicates evaluated:  %d@;\
+       asm strings rendered:  %d@;\
+       decoding time:         %.3f ms@;\
+       rendering time:        %.3f ms@;\
+       cpu cycles:            %d@;\
+       cache misses:          %d@]"
+      t.insns t.invalid t.preds t.asms
+      (ms t.decode_ns) (ms t.print_ns) t.cycles t.cache_misses
+end
+
 let create ?(debug_level=0) ?(cpu="") ~backend triple =
   let dd = match C.create ~backend ~triple ~cpu ~debug_level with
     | n when n >= 0 -> Ok n
     | -2 -> errorf "Unknown backend: %s" backend
     | -3 -> errorf "Unsupported target: %s %s" triple cpu
     |  n -> errorf "Disasm.Basic: Unknown error %d" n in
-  dd >>= fun dd -> return {
+  dd >>= fun dd ->
+  Stats.start dd;
+  let target kind = sprintf "%s:%s:%s" backend triple kind in
+  return {
     dd;
-    insn_table = Table.create (C.insn_table dd);
-    reg_table = Table.create (C.reg_table dd);
+    insn_table = Table.create ~target:(target "insn") (C.insn_table dd);
+    reg_table = Table.create ~target:(target "reg") (C.reg_table dd);
+    batch = Batch.create ();
+    asms = Asms.create ();
     asm = false;
     kinds = false;
     closed = false;
@@ -502,6 +698,7 @@ let create ?(debug_level=0) ?(cpu="") ~backend triple =
 
 
 let close dis =
+  Stats.collect dis.dd;
   C.delete dis.dd;
   dis.closed <- true
 
@@ -527,6 +724,10 @@ let store_asm d =
   C.store_asm_string !!d true;
   {d with asm = true}
 
+let cache ~capacity d =
+  C.set_cache_capacity !!d capacity;
+  d
+
 let insn_of_mem dis mem =
   let init = mem,None,`left mem in
   let split mem' =
@@ -23,6 +23,12 @@ type full_insn = (asm,kinds) insn [@@deriving compare, sexp_of]
 type ('a,'k) t
 type (+'a,+'k,'s,'r) state
 
+(** [with_disasm ?debug_level ?cpu ~backend target ~f] applies [f] to
+    a disassembler for [target].
+
+    Disassemblers share process-wide tables of interned names, that
+    are not synchronized, so disassemblers may be used by only one
+    thread at a time. *)
 val with_disasm :
   ?debug_level:int -> ?cpu:string -> backend:string -> string ->
   f:((empty, empty) t -> 'a Or_error.t) -> 'a Or_error.t
@@ -30,6 +36,12 @@ val with_disasm :
 val store_asm : (_,'k) t -> (asm,'k) t
 
 val store_kinds : ('a,_) t -> ('a,kinds) t
+
+(** [cache ~capacity d] enables a cache of decoded instructions, that
+    can hold up to [capacity] instructions, so that code, that is
+    disassembled more than once, is decoded only once. *)
+val cache : capacity:int -> ('a,'k) t -> ('a,'k) t
+
 val run :
   ?backlog:int ->
   ?stop_on:pred list ->
@@ -113,4 +125,47 @@ module Trie : sig
   include Trie with type key := key
 end
 
+(** Statistics of the disassembler backend.
+
+    When enabled, every disassembler created afterwards counts
+    decoded instructions, predicate evaluations and rendered
+    assembly strings, and measures time spent in the backend. The
+    statistics of a disassembler are added to the totals when it is
+    closed. Statistics of worker processes of a parallel disassembly
+    are added to the totals of their parent. *)
+module Stats : sig
+  type t = {
+    insns : int;             (** instructions decoded *)
+    invalid : int;           (** invalid instructions *)
+    preds : int;             (** predicates evaluated by the backend *)
+    asms : int;              (** assembly strings rendered *)
+    decode_ns : int;         (** nanoseconds spent in decoding *)
+    print_ns : int;          (** nanoseconds spent in rendering *)
+    cycles : int;            (** CPU cycles spent in the backend *)
+    cache_misses : int;      (** CPU cache misses in the backend *)
+  } [@@deriving sexp_of]
+
+  (** [enable ?counters ()] enables statistics. If [counters] is
+      [true] (defaults to [false]), then CPU cycles and cache misses
+      are read from hardware performance counters, when they are
+      available, otherwise they are zero.  *)
+  val enable : ?counters:bool -> unit -> unit
+
+  (** [disable ()] disables statistics for new disassemblers  *)
+  val disable : unit -> unit
+
+  (** [total ()] returns the totals of all closed disassemblers  *)
+  val total : unit -> t
+
+  (** [reset ()] resets the totals  *)
+  val reset : unit -> unit
+
+  (** [account stats] adds [stats] to the totals, e.g., the totals
+      of another process  *)
+  val account : t -> unit
+
+  (** [pp ppf stats] prints a human readable report  *)
+  val pp : Format.formatter -> t -> unit
+end
+
 val available_backends : unit -> string list
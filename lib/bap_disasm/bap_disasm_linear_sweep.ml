@@ -9,6 +9,7 @@ type insn = Insn.t
 type t = (mem * insn option) list
 
 module Dis = Bap_disasm_basic
+module Prim = Bap_disasm_prim
 module Targets = Bap_disasm_target_factory
 
 let lifter_of_arch arch =
@@ -32,7 +33,58 @@ let sweep arch mem : (mem * insn option) list Or_error.t =
             | _ -> mem, Some (Insn.of_basic insn)) |>
       Or_error.return)
 
+(* number of offsets that are found by one call to the length decoder *)
+let chunk = 0x10000
+
+let x86_boundaries is64 mem =
+  let buf = Memory.to_buffer mem in
+  let data = Bigsubstring.base buf and off = Bigsubstring.pos buf in
+  let len = Bigsubstring.length buf in
+  let offsets = Bigarray.(Array1.create int32 c_layout chunk) in
+  let offset i = Int32.to_int_exn offsets.{i} in
+  let rec scan acc start =
+    let n = Prim.x86_lengths data ~off:(off + start) ~len:(len - start)
+        ~is64 offsets in
+    let acc = List.fold (List.range 0 (n - 1)) ~init:acc ~f:(fun acc i ->
+        (start + offset i, offset (i+1) - offset i) :: acc) in
+    let last = start + offset (n - 1) in
+    (* when the chunk is full its last offset is not an end of the
+       sweep, but a start of the next chunk *)
+    if n = chunk && last < len then scan acc last else List.rev acc in
+  let base = Memory.min_addr mem in
+  scan [] 0 |> List.map ~f:(fun (pos,words) ->
+      Memory.view ~from:Addr.(base ++ pos) ~words mem) |>
+  Or_error.all
+
+let disasm_boundaries arch mem =
+  Dis.with_disasm ~backend:"llvm" (Arch.to_string arch) ~f:(fun dis ->
+      Dis.run dis mem
+        ~init:[] ~return:ident ~stopped:(fun s _ ->
+            Dis.stop s (Dis.insns s)) |>
+      List.map ~f:fst |>
+      Or_error.return)
+
+let boundaries arch mem = match arch with
+  | `x86 -> x86_boundaries false mem
+  | `x86_64 -> x86_boundaries true mem
+  | _ -> disasm_boundaries arch mem
+
+let decode arch mems : (mem * insn option) list Or_error.t =
+  let open Or_error.Monad_infix in
+  Dis.with_disasm ~backend:"llvm" (Arch.to_string arch) ~f:(fun dis ->
+      let dis = Dis.store_asm dis in
+      let dis = Dis.store_kinds dis in
+      let lift = lifter_of_arch arch in
+      List.map mems ~f:(fun mem ->
+          Dis.insn_of_mem dis mem >>| function
+          | mem, None, _ -> mem,None
+          | mem, Some insn, _ -> match lift mem insn with
+            | Ok bil -> mem, Some (Insn.of_basic ~bil insn)
+            | _ -> mem, Some (Insn.of_basic insn)) |>
+      Or_error.all)
 
 module With_exn = struct
   let sweep arch mem = ok_exn (sweep arch mem)
+  let boundaries arch mem = ok_exn (boundaries arch mem)
+  let decode arch mems = ok_exn (decode arch mems)
 end
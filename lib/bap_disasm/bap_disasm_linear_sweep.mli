@@ -8,6 +8,12 @@ type t = (mem * insn option) list
 
 val sweep : arch -> mem -> t Or_error.t
 
+val boundaries : arch -> mem -> mem list Or_error.t
+
+val decode : arch -> mem list -> t Or_error.t
+
 module With_exn : sig
   val sweep : arch -> mem -> t
+  val boundaries : arch -> mem -> mem list
+  val decode : arch -> mem list -> t
 end
@@ -35,6 +35,22 @@ type pred =
   | May_load
 [@@deriving compare, sexp]
 
+(** [pred_index p] is the number of [p] in bap_disasm_insn_p_type  *)
+let pred_index = function
+  | Is_true -> 0
+  | Is_invalid -> 1
+  | Is_return -> 2
+  | Is_call -> 3
+  | Is_barrier -> 4
+  | Is_terminator -> 5
+  | Is_branch -> 6
+  | Is_indirect_branch -> 7
+  | Is_conditional_branch -> 8
+  | Is_unconditional_branch -> 9
+  | May_affect_control_flow -> 10
+  | May_store -> 11
+  | May_load -> 12
+
 type op =
   | Reg
   | Imm
@@ -67,6 +83,35 @@ external store_predicates : t -> bool -> unit =
 external store_asm_string : t -> bool -> unit =
   "bap_disasm_store_asm_strings_stub" "noalloc"
 
+external set_cache_capacity : t -> int -> unit =
+  "bap_disasm_set_cache_capacity_stub" "noalloc"
+
+external cache_hits : t -> int =
+  "bap_disasm_cache_hits_stub" "noalloc"
+
+external cache_misses : t -> int =
+  "bap_disasm_cache_misses_stub" "noalloc"
+
+(** statistics, in the same order as in bap_disasm_stat  *)
+type stat =
+  | Stat_insns
+  | Stat_invalid
+  | Stat_preds
+  | Stat_asms
+  | Stat_decode_ns
+  | Stat_print_ns
+  | Stat_cycles
+  | Stat_cache_misses
+
+external stats_enable : t -> int -> unit =
+  "bap_disasm_stats_enable_stub" "noalloc"
+
+external stats_reset : t -> unit =
+  "bap_disasm_stats_reset_stub" "noalloc"
+
+external stats_get : t -> stat -> int =
+  "bap_disasm_stats_get_stub" "noalloc"
+
 external insn_table : t -> Bigstring.t =
   "bap_disasm_insn_table_stub"
 
@@ -91,6 +136,22 @@ external offset : t -> int =
 external run : t -> unit =
   "bap_disasm_run_stub" "noalloc"
 
+type batch = (int64, Bigarray.int64_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+external run_batch : t -> batch -> int =
+  "bap_disasm_run_batch_stub" "noalloc"
+
+external batch_copy : t -> batch -> int =
+  "bap_disasm_batch_copy_stub" "noalloc"
+
+type offsets = (int32, Bigarray.int32_elt, Bigarray.c_layout) Bigarray.Array1.t
+
+external asm_arena_copy : t -> Bigstring.t -> int =
+  "bap_disasm_asm_arena_copy_stub" "noalloc"
+
+external asm_index_copy : t -> offsets -> int =
+  "bap_disasm_asm_index_copy_stub" "noalloc"
+
 external insns_clear : t -> unit =
   "bap_disasm_insns_clear_stub" "noalloc"
 
@@ -140,4 +201,10 @@ external insn_op_imm_small_value : t -> insn:int -> oper:int -> int =
 external insn_op_fmm_value : t -> insn:int -> oper:int -> float =
   "bap_disasm_insn_op_fmm_value_stub"
 
+external x86_lengths :
+  Bigstring.t -> off:int -> len:int -> is64:bool -> offsets -> int =
+  "bap_disasm_x86_lengths_stub" "noalloc"
+
+external exit_immediately : int -> 'a = "bap_disasm_exit_stub" "noalloc"
+
 (**/**)
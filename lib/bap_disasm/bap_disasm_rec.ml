@@ -78,20 +78,19 @@ module type Span = sig
   val upper_bound : t -> addr -> addr option
   val min : t -> addr option
   val max : t -> addr option
+  val fold : t -> init:'a -> f:('a -> range -> 'a) -> 'a
   val pp : Format.formatter -> t -> unit
 end
 
+(* Visited ranges are stored in a balanced map from the lower bound
+   to the upper bound of a range. Ranges in the map are disjoint and
+   never adjacent, i.e., [add] merges a new range with all ranges that
+   it intersects or touches, so each address belongs to at most one
+   range, and all queries are logarithmic, independently of the order
+   in which the ranges were discovered. *)
 module Span : Span = struct
-  module Range = struct
-    module T = struct
-      type t = addr * addr [@@deriving sexp]
-      let compare (a1,_) (a2,_) = Addr.compare a1 a2
-    end
-    type t = T.t [@@deriving sexp]
-    include Comparable.Make(T)
-  end
-
-  type range = Range.t
+  type range = addr * addr
+  type t = addr Addr.Map.t
 
   let sexp_of_range (a0,a1) =
     Sexp.List [
@@ -99,67 +98,52 @@ module Span : Span = struct
       Sexp.Atom (Addr.string_of_value a1);
     ]
 
-  type t =
-    | Empty
-    | Node of t * range * addr * t
-  [@@deriving sexp_of]
-
-  let rec pp fmt = function
-    | Empty -> ()
-    | Node (lhs,(x,y),_,rhs) ->
-      Format.fprintf fmt "@[%a(%a,%a)@,%a@]"
-        pp lhs Addr.pp x Addr.pp y pp rhs
-
-  let empty = Empty
-
-  let rng_max (_,a1) a2 = Addr.max a1 a2
-
-  (** @pre: x <= p *)
-  let intersects (x,y) (p,q) = p <= y
-  (** [merge x y] if [intersects x y]  *)
-  let merge (x,p) (_,q) : range = (x, Addr.max p q)
-
-  let rec add t ((_,a1) as rng) = match t with
-    | Empty -> Node (Empty,rng,a1,Empty)
-    | Node (lhs,top,m,rhs) ->
-      let m = rng_max rng m in
-      if Range.(rng < top) then
-        if intersects rng top
-        then Node (lhs, merge rng top, m, rhs)
-        else Node (add lhs rng, top, m, rhs)
-      else if intersects top rng
-      then Node (lhs, merge top rng, m, rhs)
-      else Node (lhs, top, m, add rhs rng)
-
-  let rec mem t addr = match t with
-    | Empty -> false
-    | Node (lhs,(a0,a1),mx,rhs) ->
-      if Addr.(addr > mx) then false
-      else if Addr.(addr < a0) then mem lhs addr
-      else if Addr.(addr >= a1) then mem rhs addr
-      else true
-
-  (** [upper_bound visited addr] returns minimum address that is
-      greater than [addr] and is visited. Returns [None] if no such
-      address was found *)
-  (* returns the lowest left bound greater than [addr] *)
-  let rec upper_bound t a = match t with
-    | Empty -> None
-    | Node (_,_,mx,_) when Addr.(a > mx) -> None
-    | Node (lhs,(a0,_),_,rhs) ->
-      if Addr.(a > a0) then upper_bound rhs a
-      else match upper_bound lhs a with
-        | None -> Some a0
-        | some -> some
-
-  let rec min = function
-    | Empty -> None
-    | Node (Empty,(a0,_),_,_) -> Some a0
-    | Node (lhs,_,_,_) -> min lhs
-
-  let max = function
-    | Empty -> None
-    | Node (_,_,m,_) -> Some m
+  let sexp_of_t t =
+    Sexp.List (Map.fold_right t ~init:[] ~f:(fun ~key ~data rngs ->
+        sexp_of_range (key,data) :: rngs))
+
+  let pp fmt t =
+    Format.fprintf fmt "@[";
+    Map.iteri t ~f:(fun ~key ~data ->
+        Format.fprintf fmt "(%a,%a)@," Addr.pp key Addr.pp data);
+    Format.fprintf fmt "@]"
+
+  let empty = Addr.Map.empty
+
+  (* the range that contains or ends at [addr] *)
+  let left t addr = match Map.closest_key t `Less_or_equal_to addr with
+    | Some (_,a1) as rng when Addr.(addr <= a1) -> rng
+    | _ -> None
+
+  (* the range that starts within [a0,a1] *)
+  let right t (a0,a1) = match Map.closest_key t `Greater_or_equal_to a0 with
+    | Some (b0,_) as rng when Addr.(b0 <= a1) -> rng
+    | _ -> None
+
+  let add t (a0,a1) =
+    if Addr.(a0 >= a1) then t
+    else
+      let t,a0,a1 = match left t a0 with
+        | None -> t,a0,a1
+        | Some (b0,b1) -> Map.remove t b0, b0, Addr.max a1 b1 in
+      let rec merge t a1 = match right t (a0,a1) with
+        | None -> Map.add t ~key:a0 ~data:a1
+        | Some (b0,b1) -> merge (Map.remove t b0) (Addr.max a1 b1) in
+      merge t a1
+
+  let mem t addr = match Map.closest_key t `Less_or_equal_to addr with
+    | Some (_,a1) -> Addr.(addr < a1)
+    | None -> false
+
+  (* returns the lowest left bound greater than or equal to [addr] *)
+  let upper_bound t addr =
+    Map.closest_key t `Greater_or_equal_to addr |> Option.map ~f:fst
+
+  let min t = Map.min_elt t |> Option.map ~f:fst
+  let max t = Map.max_elt t |> Option.map ~f:snd
+
+  let fold t ~init ~f =
+    Map.fold t ~init ~f:(fun ~key ~data acc -> f acc (key,data))
 end
 
 
@@ -180,6 +164,8 @@ type stage1 = {
   dests : dests Addr.Table.t;
   errors : (addr * error) list;
   lift : lifter;
+  lifted : bil Addrs.t;   (* lifted in stage1, consumed in stage2 *)
+  capacity : int;         (* the maximum size of [lifted] *)
 }
 
 type stage2 = {
@@ -193,6 +179,7 @@ type stage2 = {
 type stage3 = {
   cfg : Cfg.t;
   failures : (addr * error) list;
+  explored : stage1;            (* kept for incremental updates *)
 }
 type t = stage3
 
@@ -217,9 +204,22 @@ let ok_nil = function
   | Ok xs -> xs
   | Error _ -> []
 
+(* the default number of instructions, lifted by the first stage,
+   that are kept for the second stage. Instructions beyond this are
+   lifted again. *)
+let lifted_capacity = 0x40000
+
+let lift s mem insn =
+  let bil = s.lift mem insn in
+  let () = match bil with
+    | Ok bil when Addrs.length s.lifted < s.capacity ->
+      Addrs.set s.lifted ~key:(Memory.min_addr mem) ~data:bil
+    | _ -> () in
+  bil
+
 let is_barrier s mem insn =
   Dis.Insn.is insn `May_affect_control_flow ||
-  has_jump (ok_nil (s.lift mem insn))
+  has_jump (ok_nil (lift s mem insn))
 
 let update s mem insn dests : stage1 =
   if is_barrier s mem insn then
@@ -233,6 +233,11 @@ let update s mem insn dests : stage1 =
     s with roots = Addr.succ (Memory.max_addr mem) :: s.roots
   }
 
+(* memory from [addr] up to the next visited region *)
+let unexplored s addr = match Span.upper_bound s.visited addr with
+  | None -> Memory.view ~from:addr s.base
+  | Some r1 -> Memory.range s.base addr r1
+
 (* switch to next root or finish if there're no roots *)
 let next dis s =
   let rec loop s = match s.roots with
@@ -242,9 +247,7 @@ let next dis s =
     | r :: roots when Span.mem s.visited r ->
       loop {s with roots}
     | addr :: roots ->
-      let mem = match Span.upper_bound s.visited addr with
-        | None -> Memory.view ~from:addr s.base
-        | Some r1 -> Memory.range s.base addr r1  in
+      let mem = unexplored s addr in
       let mem =
         Result.map_error mem ~f:(fun err -> Error.tag err "next_root") in
       mem >>= fun mem -> Dis.jump dis mem {s with roots; addr} in
@@ -253,21 +256,181 @@ let next dis s =
 
 let stop_on = [`May_affect_control_flow; `May_load]
 
-let stage1 ?(rooter=Rooter.empty) lift brancher disasm base =
-  let roots =
-    Rooter.roots rooter |> Seq.filter ~f:(Memory.contains base) in
-  let addr,roots = match Seq.to_list roots with
-    | r :: rs -> r,rs
-    | [] -> Memory.min_addr base, [] in
-  let init = {base; addr; visited = Span.empty;
-              roots; inits = roots;
-              dests = Addr.Table.create (); errors = []; lift} in
-  Memory.view ~from:addr base >>= fun mem ->
+(* instructions decoded in the first stage are decoded again in the
+   second, so they are cached (up to the capacity). *)
+let cache_capacity = 0x40000
+
+let roots_of_rooter rooter base =
+  Rooter.roots rooter |> Seq.filter ~f:(Memory.contains base) |>
+  Seq.to_list
+
+(* explores the control flow from [init.addr] and [init.roots] *)
+let explore brancher disasm init =
+  unexplored init init.addr >>= fun mem ->
   Dis.run disasm mem ~stop_on:[`May_affect_control_flow] ~return ~init
     ~hit:(fun d mem insn s -> next d (update s mem insn (brancher mem insn)))
     ~invalid:(fun d mem s -> next d (errored s (`Failed_to_disasm mem)))
     ~stopped:next
 
+let stage1 ~capacity lift brancher disasm base roots =
+  let addr,roots = match roots with
+    | r :: rs -> r,rs
+    | [] -> Memory.min_addr base, [] in
+  explore brancher disasm {
+    base; addr; visited = Span.empty;
+    roots; inits = roots;
+    dests = Addr.Table.create (); errors = []; lift;
+    lifted = Addrs.create (); capacity;
+  }
+
+(* Parallel version of the first stage.
+
+   Roots are sorted and split into clusters of adjacent roots, and
+   each cluster is explored by a separate worker process, that has its
+   own disassembler. Workers send back visited spans, destinations and
+   errors, that are merged into one stage1 result. A worker may
+   follow the control flow into a region of another cluster, so some
+   code can be explored more than once. The merged result is not
+   necessarily the same as the sequential one: it visits a superset
+   of the addresses, that the sequential exploration visits, and the
+   destinations of an instruction, that was explored by several
+   workers, are the union of their findings.
+
+   Several independent memory regions (e.g., members of an archive)
+   are explored the same way, except that each region is explored by
+   one worker, and a worker may explore several regions. *)
+module Parallel = struct
+  (* results are marshaled, so they must not contain closures, like
+     comparators of maps. Spans are sent as (start, length) pairs. *)
+  type result = {
+    explored : (addr * int) list;
+    found : (addr * dests) list;
+    (* root, address and size of undecodable memory *)
+    failed : (addr * addr * int) list;
+  }
+
+  (* Memory is not sent back, as it references the whole image, so
+     errors are reconstructed from addresses. The first stage can't
+     fail to lift, so only disassembling errors are exported. *)
+  let export (s : stage1) = {
+    explored = Span.fold s.visited ~init:[] ~f:(fun spans (a0,a1) ->
+        (a0, Addr.to_int (Addr.diff a1 a0) |> ok_exn) :: spans);
+    found = Addr.Table.to_alist s.dests;
+    failed = List.filter_map s.errors ~f:(function
+        | addr, `Failed_to_disasm mem ->
+          Some (addr, Memory.min_addr mem, Memory.length mem)
+        | _ -> None);
+  }
+
+  let clusters jobs roots =
+    let roots =
+      List.dedup ~compare:Addr.compare roots |>
+      List.sort ~cmp:Addr.compare in
+    let size = (List.length roots + jobs - 1) / jobs in
+    List.groupi roots ~break:(fun i _ _ -> i mod size = 0)
+
+  let flush () =
+    Out_channel.flush stdout;
+    Out_channel.flush stderr;
+    Format.pp_print_flush Format.std_formatter ();
+    Format.pp_print_flush Format.err_formatter ()
+
+  (* a worker sends its results with the statistics of its
+     disassemblers, and exits immediately, so that at_exit handlers
+     and buffers, inherited from the parent, are not run twice *)
+  let spawn work =
+    let rd,wr = Unix.pipe () in
+    flush ();
+    match Unix.fork () with
+    | 0 ->
+      Unix.close rd;
+      Dis.Stats.reset ();
+      let res : (result list,string) Result.t =
+        try match work () with
+          | Ok ss -> Ok (List.map ss ~f:export)
+          | Error err -> Error (Error.to_string_hum err)
+        with exn -> Error (Exn.to_string exn) in
+      begin try
+          let out = Unix.out_channel_of_descr wr in
+          Marshal.to_channel out (res, Dis.Stats.total ()) [];
+          Out_channel.close out
+        with _ -> ()
+      end;
+      Bap_disasm_prim.exit_immediately 0
+    | pid ->
+      Unix.close wr;
+      pid, Unix.in_channel_of_descr rd
+
+  let collect (pid,input) =
+    let res : (result list,string) Result.t =
+      try
+        let res,stats = Marshal.from_channel input in
+        Dis.Stats.account stats;
+        res
+      with End_of_file -> Error "disassembler worker has died" in
+    In_channel.close input;
+    ignore (Unix.waitpid [] pid);
+    Result.map_error res ~f:Error.of_string
+
+  let same_dest (a1,e1) (a2,e2) =
+    Option.equal Addr.equal a1 a2 && compare_edge e1 e2 = 0
+
+  let merge_dests table (key,dests) =
+    Addr.Table.change table key ~f:(function
+        | None -> Some dests
+        | Some known ->
+          let is_new d = not (List.mem ~equal:same_dest known d) in
+          Some (known @ List.filter dests ~f:is_new))
+
+  let merge base s {explored; found; failed} =
+    let visited = List.fold explored ~init:s.visited
+        ~f:(fun visited (addr,len) ->
+            Span.add visited (addr, Addr.nsucc addr len)) in
+    List.iter found ~f:(merge_dests s.dests);
+    let errors = List.fold failed ~init:s.errors
+        ~f:(fun errors (addr,from,words) ->
+            match Memory.view ~from ~words base with
+            | Ok mem -> (addr, `Failed_to_disasm mem) :: errors
+            | Error _ -> errors) in
+    {s with visited; errors}
+
+  let init ~capacity lift base roots = {
+    base; addr = Memory.min_addr base; visited = Span.empty;
+    roots = []; inits = roots;
+    dests = Addr.Table.create (); errors = []; lift;
+    lifted = Addrs.create (); capacity;
+  }
+
+  let stage1 ~jobs ~backend ~capacity arch lift brancher base roots =
+    clusters jobs roots |>
+    List.map ~f:(fun roots -> spawn (fun () ->
+        Dis.with_disasm ~backend (Arch.to_string arch) ~f:(fun dis ->
+            stage1 ~capacity lift brancher dis base roots >>|
+            List.return))) |>
+    List.map ~f:collect |>
+    List.fold ~init:(Ok (init ~capacity lift base roots)) ~f:(fun s r ->
+        s >>= fun s -> r >>| List.fold ~init:s ~f:(merge base))
+
+  (* regions are dealt to workers round-robin, a worker returns the
+     results in the order of its regions. *)
+  let regions ~jobs ~backend ~capacity arch lift brancher regions =
+    let regions = List.mapi regions ~f:(fun i r -> i,r) in
+    List.init jobs ~f:(fun job ->
+        List.filter regions ~f:(fun (i,_) -> i mod jobs = job)) |>
+    List.filter ~f:(fun rs -> not (List.is_empty rs)) |>
+    List.map ~f:(fun rs -> rs, spawn (fun () ->
+        Dis.with_disasm ~backend (Arch.to_string arch) ~f:(fun dis ->
+            List.map rs ~f:(fun (_,(base,roots)) ->
+                stage1 ~capacity lift brancher dis base roots) |>
+            Or_error.all))) |>
+    List.map ~f:(fun (rs,worker) ->
+        collect worker >>| List.map2_exn rs ~f:(fun (i,(base,roots)) r ->
+            i, merge base (init ~capacity lift base roots) r)) |>
+    Or_error.all >>| List.concat >>|
+    List.sort ~cmp:(fun (i,_) (j,_) -> Int.compare i j) >>|
+    List.map ~f:snd
+end
+
 (* performs the initial markup.
 
    Returns three tables: leads, terms, and kinds. Leads is a mapping
@@ -295,21 +458,70 @@ let create_indexes (dests : dests Addr.Table.t) =
             Addrs.add_multi terms ~key:src ~data:dst));
   leads, terms, succs
 
+(* A dense set of offsets in a memory region, one bit per byte.  *)
+module Bitset : sig
+  type t
+  val create : int -> t
+  val set : t -> int -> unit
+
+  (** [next t off] returns the least member of [t] that is greater
+      than or equal to [off]  *)
+  val next : t -> int -> int option
+end = struct
+  type t = int array
+
+  let bits = Sys.word_size - 1
+
+  let create size = Array.create ~len:((size + bits - 1) / bits) 0
+
+  let set t off =
+    let w = off / bits in
+    t.(w) <- t.(w) lor (1 lsl (off mod bits))
+
+  (* the number of trailing zeros, @pre x <> 0 *)
+  let rec ctz x n =
+    if x land 0xFFFF = 0 then ctz (x lsr 16) (n + 16) else
+    if x land 0xFF = 0 then ctz (x lsr 8) (n + 8) else
+    if x land 0xF = 0 then ctz (x lsr 4) (n + 4) else
+    if x land 1 = 0 then ctz (x lsr 1) (n + 1) else n
+
+  let next t off =
+    let rec scan w =
+      if w >= Array.length t then None
+      else if t.(w) = 0 then scan (w + 1)
+      else Some (w * bits + ctz t.(w) 0) in
+    let w = off / bits in
+    if w >= Array.length t then None
+    else
+      let x = t.(w) land (-1 lsl (off mod bits)) in
+      if x <> 0 then Some (w * bits + ctz x 0)
+      else scan (w + 1)
+end
+
+(* [block_ends stage1 leads] marks addresses, after which a block
+   must be terminated, i.e., terminators of explored instructions and
+   predecessors of leaders and initial roots.  *)
+let block_ends stage1 leads =
+  let base = stage1.base in
+  let min = Memory.min_addr base in
+  let ends = Bitset.create (Memory.length base) in
+  let mark addr =
+    if Memory.contains base addr then
+      Bitset.set ends (Addr.to_int (Addr.diff addr min) |> ok_exn) in
+  Addrs.iteri stage1.dests ~f:(fun ~key ~data:_ -> mark key);
+  Addrs.iteri leads ~f:(fun ~key ~data:_ -> mark (Addr.pred key));
+  List.iter stage1.inits ~f:(fun addr -> mark (Addr.pred addr));
+  ends
+
 let stage2 dis stage1 =
   let leads, terms, kinds = create_indexes stage1.dests in
   let addrs = Addrs.create () in
   let succs = Addrs.create () in
   let preds = Addrs.create () in
-  let inits =
-    List.fold ~init:Addr.Set.empty stage1.inits ~f:Set.add in
   let next = Addr.succ in
-  let is_edge addr =
-    Addrs.mem leads (next addr) ||
-    Addrs.mem kinds addr ||
-    Addrs.mem stage1.dests addr ||
-    Addr.Set.mem inits (next addr) in
-  let is_visited = Span.mem stage1.visited in
-  let next_visited = Span.upper_bound stage1.visited in
+  let ends = block_ends stage1 leads in
+  let min = Memory.min_addr stage1.base in
+  let offset addr = Addr.to_int (Addr.diff addr min) |> ok_exn in
   let create_block start finish =
     Memory.range stage1.base start finish >>= fun blk ->
     Addrs.add_exn addrs ~key:start ~data:blk;
@@ -327,21 +539,26 @@ let stage2 dis stage1 =
     Addrs.add_exn succs ~key:start ~data:dests;
     return () in
 
-  let rec loop start curr' =
-    let curr = next curr' in
-    if is_visited curr then
-      if is_edge curr then
-        create_block start curr >>= fun () ->
-        loop (next curr) curr
-      else loop start curr
-    else match next_visited curr with
-      | Some addr -> loop addr addr
-      | None when is_visited start && is_visited curr' ->
-        create_block start curr'
-      | None -> return () in
-  match Span.min stage1.visited with
+  (* Splits a visited range [start,finish) into blocks, jumping from
+     one block end to another. An unterminated tail is a block only
+     in the last range.  *)
+  let split last (start,finish) =
+    let finish = offset finish in
+    let rec loop start =
+      match Bitset.next ends start with
+      | Some off when off < finish ->
+        create_block (Addr.nsucc min start) (Addr.nsucc min off) >>= fun () ->
+        loop (off + 1)
+      | _ when last && start < finish ->
+        create_block (Addr.nsucc min start) (Addr.nsucc min (finish - 1))
+      | _ -> return () in
+    loop (offset start) in
+  let split_all last =
+    Span.fold stage1.visited ~init:(return ()) ~f:(fun r (x,y) ->
+        r >>= fun () -> split Addr.(y = last) (x,y)) in
+  match Span.max stage1.visited with
   | None -> errorf "Provided memory doesn't contain a recognizable code"
-  | Some addr -> loop addr addr >>= fun () ->
+  | Some last -> split_all last >>= fun () ->
     let dis = Dis.store_asm dis in
     let dis = Dis.store_kinds dis in
     let disasm mem =
@@ -350,12 +567,18 @@ let stage2 dis stage1 =
             Dis.stop s (Dis.insns s)) |>
       List.map ~f:(function
           | mem, None -> mem,(None,None)
-          | mem, (Some ins as insn) -> match stage1.lift mem ins with
-            | Ok bil -> mem,(insn,Some bil)
-            | _ -> mem, (insn, None)) in
+          | mem, (Some ins as insn) ->
+            let addr = Memory.min_addr mem in
+            match Addrs.find_and_remove stage1.lifted addr with
+            | Some bil -> mem,(insn,Some bil)
+            | None -> match stage1.lift mem ins with
+              | Ok bil -> mem,(insn,Some bil)
+              | _ -> mem, (insn, None)) in
     return {stage1; addrs; succs; preds; disasm}
 
-let stage3 s2 =
+(* [reuse addr mem] returns a block, that was already decoded from
+   the same memory in a previous run. *)
+let stage3 ?(reuse=fun _ _ -> None) s2 =
   let is_found addr = Addrs.mem s2.addrs addr in
   let pred_is_found = is_found in
   let succ_is_found = function
@@ -371,15 +594,19 @@ let stage3 s2 =
     preds = filter s2.preds ~f:pred_is_found;
   } in
   let nodes = Addrs.create () in
+  let decode addr mem =
+    s2.disasm mem |> List.filter_map ~f:(function
+        | mem,(None,_) -> None
+        | mem,(Some insn,bil) ->
+          Some (mem, Insn.of_basic ?bil insn)) |> function
+    | [] -> ()
+    | insns ->
+      let node = Block.create mem insns in
+      Addrs.set nodes ~key:addr ~data:node in
   Addrs.iteri s2.addrs ~f:(fun ~key:addr ~data:mem ->
-      s2.disasm mem |> List.filter_map ~f:(function
-          | mem,(None,_) -> None
-          | mem,(Some insn,bil) ->
-            Some (mem, Insn.of_basic ?bil insn)) |> function
-      | [] -> ()
-      | insns ->
-        let node = Block.create mem insns in
-        Addrs.set nodes ~key:addr ~data:node);
+      match reuse addr mem with
+      | Some node -> Addrs.set nodes ~key:addr ~data:node
+      | None -> decode addr mem);
   let cfg =
     Addrs.fold nodes ~init:Cfg.empty ~f:(fun ~key:addr ~data:x cfg ->
         match Addrs.find s2.succs addr with
@@ -392,15 +619,124 @@ let stage3 s2 =
                 | Some y ->
                   let edge = Cfg.Edge.create x y e in
                   Cfg.Edge.insert edge cfg)) in
-  return {cfg; failures = s2.stage1.errors}
+  return {cfg; failures = s2.stage1.errors; explored = s2.stage1}
 
-let run ?(backend="llvm") ?brancher ?rooter arch mem =
+let run ?(backend="llvm") ?brancher ?rooter ?(jobs=1)
+    ?(lifted_capacity=lifted_capacity) arch mem =
   let b = Option.value brancher ~default:(Brancher.of_bil arch) in
   let brancher = Brancher.resolve b in
   let module Target = (val Targets.target_of_arch arch) in
   let lifter = Target.lift in
+  let roots = match rooter with
+    | None -> []
+    | Some rooter -> roots_of_rooter rooter mem in
+  Dis.with_disasm ~backend (Arch.to_string arch) ~f:(fun dis ->
+      let dis = Dis.cache ~capacity:cache_capacity dis in
+      let stage1 =
+        let capacity = lifted_capacity in
+        if jobs > 1 && List.length roots > 1
+        then Parallel.stage1 ~jobs ~backend ~capacity
+            arch lifter brancher mem roots
+        else stage1 ~capacity lifter brancher dis mem roots in
+      stage1 >>= stage2 dis >>= stage3)
+
+let run_all ?(backend="llvm") ?brancher ?rooter ?(jobs=1)
+    ?(lifted_capacity=lifted_capacity) arch mems =
+  let b = Option.value brancher ~default:(Brancher.of_bil arch) in
+  let brancher = Brancher.resolve b in
+  let module Target = (val Targets.target_of_arch arch) in
+  let lifter = Target.lift in
+  let regions = List.map mems ~f:(fun mem -> mem, match rooter with
+    | None -> []
+    | Some rooter -> roots_of_rooter rooter mem) in
+  Dis.with_disasm ~backend (Arch.to_string arch) ~f:(fun dis ->
+      let dis = Dis.cache ~capacity:cache_capacity dis in
+      let stage1 =
+        let capacity = lifted_capacity in
+        if jobs > 1 && List.length regions > 1
+        then Parallel.regions ~jobs ~backend ~capacity
+            arch lifter brancher regions
+        else List.map regions ~f:(fun (mem,roots) ->
+            stage1 ~capacity lifter brancher dis mem roots) |>
+             Or_error.all in
+      stage1 >>= fun ss ->
+      List.map ss ~f:(fun s -> stage2 dis s >>= stage3) |> Or_error.all)
+
+(* Incremental update.
+
+   Blocks that intersect changed memory are invalidated. Their memory
+   is removed from the visited span, and the destinations of their
+   terminators, as well as errors found in them, are forgotten. The
+   first stage is resumed from the starts of invalidated blocks, with
+   the rest of the explored state intact, so that only the code that
+   is reachable from them and was not visited before is decoded. The
+   second stage is rerun as is, since it doesn't decode anything, and
+   the third stage reuses all blocks, that do not intersect the
+   changes and still have the same extent. *)
+
+(* a half-open range [min,max+1) of a memory region  *)
+let extent mem = Memory.min_addr mem, Addr.succ (Memory.max_addr mem)
+
+let intersects (x0,x1) (y0,y1) = Addr.(x0 < y1 && y0 < x1)
+
+(* [subtract span holes] removes [holes] from [span]  *)
+let subtract span holes =
+  let cut ((x0,x1) as rng) ((h0,h1) as hole) =
+    if not (intersects rng hole) then [rng]
+    else List.filter ~f:(fun (x,y) -> Addr.(x < y))
+        [x0, Addr.min x1 h0; Addr.max x0 h1, x1] in
+  Span.fold span ~init:Span.empty ~f:(fun span rng ->
+      List.fold holes ~init:[rng] ~f:(fun rngs hole ->
+          List.concat_map rngs ~f:(fun rng -> cut rng hole)) |>
+      List.fold ~init:span ~f:Span.add)
+
+let invalidate t changes =
+  let s = t.explored in
+  let is_changed rng = List.exists changes ~f:(intersects rng) in
+  let blocks =
+    Cfg.nodes t.cfg |> Seq.map ~f:Block.memory |> Seq.map ~f:extent |>
+    Seq.filter ~f:is_changed |> Seq.to_list in
+  let holes = changes @ blocks in
+  let in_holes addr =
+    List.exists holes ~f:(fun (x,y) -> Addr.(addr >= x && addr < y)) in
+  let dests = Addr.Table.create () in
+  Addr.Table.iteri s.dests ~f:(fun ~key ~data ->
+      if not (in_holes key) then Addr.Table.set dests ~key ~data);
+  let lifted = Addrs.create () in
+  Addrs.iteri s.lifted ~f:(fun ~key ~data ->
+      if not (in_holes key) then Addrs.set lifted ~key ~data);
+  let errors,failed = List.partition_tf s.errors ~f:(fun (_,err) ->
+      match err with
+      | `Failed_to_disasm mem
+      | `Failed_to_lift (mem,_,_) -> not (is_changed (extent mem))) in
+  let roots =
+    List.map blocks ~f:fst @
+    List.map failed ~f:fst @
+    List.filter s.inits ~f:in_holes in
+  {s with visited = subtract s.visited holes; dests; errors; lifted}, roots
+
+let update ?(backend="llvm") ?brancher arch t base changes =
+  let b = Option.value brancher ~default:(Brancher.of_bil arch) in
+  let brancher = Brancher.resolve b in
+  let changes = List.map changes ~f:extent in
+  let s,roots = invalidate t changes in
+  let s = {s with base} in
+  let roots = List.filter roots ~f:(fun r ->
+      Memory.contains base r && not (Span.mem s.visited r)) in
+  let known = Addrs.create () in
+  Seq.iter (Cfg.nodes t.cfg) ~f:(fun blk ->
+      Addrs.set known ~key:(Block.addr blk) ~data:blk);
+  let reuse addr mem = match Addrs.find known addr with
+    | Some blk when Memory.length (Block.memory blk) = Memory.length mem &&
+                    not (List.exists changes ~f:(intersects (extent mem))) ->
+      Some (Block.create mem (Block.insns blk))
+    | _ -> None in
   Dis.with_disasm ~backend (Arch.to_string arch) ~f:(fun dis ->
-      stage1 ?rooter lifter brancher dis mem >>= stage2 dis >>= stage3)
+      let dis = Dis.cache ~capacity:cache_capacity dis in
+      let stage1 = match roots with
+        | [] -> return s
+        | addr :: roots -> explore brancher dis {s with addr; roots} in
+      stage1 >>= stage2 dis >>= stage3 ~reuse)
 
 let cfg t = t.cfg
 let errors s = List.map s.failures ~f:snd
@@ -25,10 +25,51 @@ type error = [
   | `Failed_to_lift of mem * full_insn * Error.t
 ] [@@deriving sexp_of]
 
+(** [run ?backend ?brancher ?rooter ?jobs ?lifted_capacity arch mem]
+    disassembles memory [mem] starting from roots, provided by
+    [rooter].
+
+    If [jobs] is greater than one (defaults to one), then the roots
+    are split into [jobs] clusters, and the control flow of each
+    cluster is explored in a separate process.
+
+    Up to [lifted_capacity] instructions (defaults to [0x40000]),
+    lifted while the control flow is explored, are kept for building
+    the blocks; the rest are lifted once again. *)
 val run :
   ?backend:string ->
   ?brancher:brancher ->
-  ?rooter:rooter -> arch -> mem -> t Or_error.t
+  ?rooter:rooter ->
+  ?jobs:int ->
+  ?lifted_capacity:int -> arch -> mem -> t Or_error.t
+
+(** [run_all ?backend ?brancher ?rooter ?jobs ?lifted_capacity arch mems]
+    disassembles each memory region in [mems] as {!run} does, and
+    returns the results in the same order.
+
+    If [jobs] is greater than one, then the regions are explored by
+    up to [jobs] processes, each region by a single process. *)
+val run_all :
+  ?backend:string ->
+  ?brancher:brancher ->
+  ?rooter:rooter ->
+  ?jobs:int ->
+  ?lifted_capacity:int -> arch -> mem list -> t list Or_error.t
+
+(** [update ?backend ?brancher arch t mem changes] updates the
+    result [t] of a previous disassembly, after the memory regions
+    [changes] were modified. The [mem] region is the new contents of
+    the memory, that was disassembled by [t], and must span the same
+    addresses.
+
+    Only blocks that intersect [changes] are disassembled again,
+    together with code that becomes reachable from them. Other blocks
+    are reused, provided that their extent has not changed. The
+    result can be updated again. *)
+val update :
+  ?backend:string ->
+  ?brancher:brancher ->
+  arch -> t -> mem -> mem list -> t Or_error.t
 
 val cfg : t -> Cfg.t
 
@@ -7,6 +7,15 @@
 #include <iterator>
 #include <cassert>
 #include <cstring>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 // debug REMOVE
 #include <iostream>
@@ -23,7 +32,10 @@ using vector = std::vector<T>;
 template <typename T>
 using shared_ptr = std::shared_ptr<T>;
 
+using lock_guard = std::lock_guard<std::mutex>;
+
 static std::map<string, shared_ptr<disasm_factory>> backends;
+static std::mutex backends_lock;
 
 static auto all_predicates = {
     is_true,
@@ -42,6 +54,7 @@ static auto all_predicates = {
 };
 
 int register_disassembler(string name, shared_ptr<disasm_factory> f) {
+    lock_guard guard(backends_lock);
     if (backends.find(name) != backends.end())
         return -1;
     backends[name] = f;
@@ -70,41 +83,228 @@ fmm operand_value<fmm>(operand op) {
     return op.fmm_val;
 }
 
+// an instruction, stored in a queue. The first inline_ops operands
+// are stored in the instruction itself, and the rest are spilled
+// into the overflow slab of the queue.
+struct queued_insn {
+    enum { inline_ops = 8 };
+    int code;
+    int name;
+    location loc;
+    int ops_size;
+    int spill;                  // offset of spilled operands in the slab
+    operand ops[inline_ops];
+};
+
+// An arena of instructions.
+//
+// Instructions are stored in a contiguous array, that is never
+// shrinked, so that once the queue has grown to its working size no
+// more allocations are performed. Clearing the queue is O(1).
+class insn_queue {
+    vector<queued_insn> insns;
+    vector<operand> slab;
+    std::size_t insns_size;
+    std::size_t slab_size;
+    std::size_t ops_total;
+
+public:
+    insn_queue() : insns_size(0), slab_size(0), ops_total(0) {}
+
+    void push_back(const insn &src) {
+        if (insns_size == insns.size())
+            insns.resize(std::max<std::size_t>(64, 2 * insns.size()));
+        queued_insn &dst = insns[insns_size++];
+        dst.code = src.code;
+        dst.name = src.name;
+        dst.loc = src.loc;
+        dst.ops_size = src.ops.size();
+        dst.spill = slab_size;
+        ops_total += src.ops.size();
+        for (std::size_t i = 0; i < src.ops.size(); i++) {
+            if (i < queued_insn::inline_ops) {
+                dst.ops[i] = src.ops[i];
+            } else {
+                if (slab_size == slab.size())
+                    slab.resize(std::max<std::size_t>(64, 2 * slab.size()));
+                slab[slab_size++] = src.ops[i];
+            }
+        }
+    }
+
+    void clear() {
+        insns_size = 0;
+        slab_size = 0;
+        ops_total = 0;
+    }
+
+    std::size_t size() const {
+        return insns_size;
+    }
+
+    // total amount of operands of all instructions in the queue
+    std::size_t operands() const {
+        return ops_total;
+    }
+
+    const queued_insn &operator[](std::size_t i) const {
+        assert(i < insns_size);
+        return insns[i];
+    }
+
+    const operand &oper(std::size_t i, int j) const {
+        const queued_insn &insn = (*this)[i];
+        assert(j >= 0 && j < insn.ops_size);
+        if (j < queued_insn::inline_ops)
+            return insn.ops[j];
+        else
+            return slab[insn.spill + j - queued_insn::inline_ops];
+    }
+};
+
+// a hardware event counter of the calling thread, that always reads
+// zero if it is not available.
+class hw_counter {
+    int fd;
+public:
+    explicit hw_counter(uint64_t config) : fd(-1) {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    hw_counter(const hw_counter&) = delete;
+    hw_counter& operator=(const hw_counter&) = delete;
+
+    ~hw_counter() {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    int64_t read() const {
+#ifdef __linux__
+        int64_t value;
+        if (fd >= 0 && ::read(fd, &value, sizeof(value)) == sizeof(value))
+            return value;
+#endif
+        return 0;
+    }
+};
+
+// statistics of a disassembler, see bap_disasm_stats_enable.
+class stats {
+    using clock = std::chrono::steady_clock;
+
+    int64_t values[bap_disasm_stats_size];
+    std::unique_ptr<hw_counter> cycles;
+    std::unique_ptr<hw_counter> misses;
+    int64_t cycles_start, misses_start;
+
+public:
+    explicit stats(int level) : cycles_start(0), misses_start(0) {
+        reset();
+#ifdef __linux__
+        if (level > 1) {
+            cycles.reset(new hw_counter(PERF_COUNT_HW_CPU_CYCLES));
+            misses.reset(new hw_counter(PERF_COUNT_HW_CACHE_MISSES));
+        }
+#endif
+    }
+
+    void reset() {
+        std::fill(values, values + bap_disasm_stats_size, 0);
+    }
+
+    int64_t get(bap_disasm_stat s) const {
+        return values[s];
+    }
+
+    void count(bap_disasm_stat s) {
+        values[s]++;
+    }
+
+    clock::time_point now() const {
+        return clock::now();
+    }
+
+    void elapsed(bap_disasm_stat s, clock::time_point start) {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>
+            (clock::now() - start);
+        values[s] += ns.count();
+    }
+
+    void start_run() {
+        if (cycles) {
+            cycles_start = cycles->read();
+            misses_start = misses->read();
+        }
+    }
+
+    void stop_run() {
+        if (cycles) {
+            values[bap_disasm_stat_cycles] += cycles->read() - cycles_start;
+            values[bap_disasm_stat_cache_misses] +=
+                misses->read() - misses_start;
+        }
+    }
+};
+
 class disassembler {
-    using predicates = std::vector<bap_disasm_insn_p_type>;
-    using pred = predicates::value_type;
     using subkey = std::pair<int,int>;
 
     shared_ptr<disassembler_interface> dis;
-    predicates supported_predicates;
-    predicates preds;
-    vector<insn> insns;
-    vector<string>  asms;
+    preds_mask supported_predicates;
+    preds_mask preds;
+    insn_queue insns;
+    // asm strings of all queued instructions, the string of the
+    // instruction i is in the range [asm_offsets[i], asm_offsets[i+1])
+    string asms;
+    vector<int> asm_offsets;
     string asm_cache;
-    vector<predicates> insn_preds;
+    bool asm_cached;
+    vector<preds_mask> insn_preds;
     int64_t base;
     int off;
     bool store_preds, store_asms;
+    std::unique_ptr<stats> stat;
 
 
     disassembler(shared_ptr<disassembler_interface> dis)
         : dis(dis)
+        , supported_predicates(0)
+        , preds(0)
+        , asm_offsets(1, 0)
+        , asm_cached(false)
         , base(0L)
         , off(0)
         , store_preds(false)
         , store_asms(false) {
         for (auto p : all_predicates) {
             if (dis->supports(p))
-                supported_predicates.push_back(p);
+                supported_predicates |= pred_bit(p);
         }
-        // it should be already sorted, but nothing worse if will do it twice.
-        sort(supported_predicates.begin(), supported_predicates.end());
     }
 
 public:
     static result<disassembler>
     create(const char *name, const char *triple, const char *cpu, int debug_level) {
-        if (auto factory = backends[name]) {
+        shared_ptr<disasm_factory> factory;
+        {
+            lock_guard guard(backends_lock);
+            auto it = backends.find(name);
+            if (it != backends.end())
+                factory = it->second;
+        }
+        if (factory) {
             auto result = factory->create(triple, cpu, debug_level);
             if (!result.dis) {
                 return {nullptr, result.err};
@@ -116,12 +316,38 @@ public:
             return {nullptr, bap_disasm_no_such_backend};
     }
 
+    // creates a fresh disassembler, that shares the backend's
+    // target description with this one.
+    result<disassembler> clone() const {
+        auto copy = dis->clone();
+        if (!copy)
+            return {nullptr, bap_disasm_unknown_error};
+        return {shared_ptr<disassembler>(new disassembler(copy)), 0};
+    }
+
     void run() {
+        if (stat) stat->start_run();
         while (1) {
             bool finished = step();
             if (finished)
-                return;
+                break;
         };
+        if (stat) stat->stop_run();
+    }
+
+    void enable_stats(int level) {
+        if (level > 0)
+            stat.reset(new stats(level));
+        else
+            stat.reset();
+    }
+
+    void reset_stats() {
+        if (stat) stat->reset();
+    }
+
+    int64_t get_stat(bap_disasm_stat s) const {
+        return stat ? stat->get(s) : 0;
     }
 
     void set_memory(int64_t addr, const char *data, int offset, int length) {
@@ -139,21 +365,20 @@ public:
     void enable_store_asms(bool enable) {
         store_asms = enable;
         if (enable == false)
-            asms.clear();
+            clear_asms();
     }
 
     void push_pred(bap_disasm_insn_p_type p) {
-        preds.push_back(p);
-        sort(preds.begin(), preds.end());
+        preds |= pred_bit(p);
     }
 
     void clear_preds() {
-        preds.clear();
+        preds = 0;
     }
 
     void clear_insns() {
         insns.clear();
-        asms.clear();
+        clear_asms();
         insn_preds.clear();
     }
 
@@ -161,6 +386,14 @@ public:
         return insns.size();
     }
 
+    void set_cache_capacity(std::size_t capacity) {
+        dis->set_cache_capacity(capacity);
+    }
+
+    cache_stats get_cache_stats() const {
+        return dis->get_cache_stats();
+    }
+
     table insn_table() const {
         return dis->insn_table();
     }
@@ -180,30 +413,44 @@ public:
 
         if (store_preds) {
             assert(n >= 0 && n < insn_preds.size());
-            auto beg = insn_preds[n].begin(), end = insn_preds[n].end();
-            return std::binary_search(beg, end, p);
+            return insn_preds[n] & pred_bit(p);
         } else {
             assert (n == queue_size() - 1);
+            if (stat) stat->count(bap_disasm_stat_preds);
             return dis->satisfies(p);
         }
     }
 
-    string get_asm(int n) {
+    // returns the asm string of the n-th instruction, the pointer
+    // is valid until the next step or clear.
+    const char *asm_data(int n) {
         if (store_asms) {
-            assert(n >= 0 && n < asms.size());
-            return asms[n];
+            assert(n >= 0 && n < queue_size());
+            return asms.data() + asm_offsets[n];
         } else {
             assert(n == queue_size() - 1);
-            if (asms.size() == 1)
-                return asms[0];
-            else {
-                if (asm_cache.empty())
-                    asm_cache = dis->get_asm();
-                return asm_cache;
-            }
+            return last_asm().data();
+        }
+    }
+
+    int asm_size(int n) {
+        if (store_asms) {
+            assert(n >= 0 && n < queue_size());
+            return asm_offsets[n+1] - asm_offsets[n];
+        } else {
+            assert(n == queue_size() - 1);
+            return last_asm().size();
         }
     }
 
+    const string &asm_arena() const {
+        return asms;
+    }
+
+    const vector<int> &asm_index() const {
+        return asm_offsets;
+    }
+
     void set_offset(int new_off) {
         off = new_off;
     }
@@ -212,60 +459,248 @@ public:
         return off;
     }
 
-    const insn& nth_insn(int i) const {
-        assert(i < insns.size());
+    const queued_insn& nth_insn(int i) const {
         return insns[i];
     }
 
     template <typename OpVal>
     OpVal oper_value(int i, int j) const {
-        auto insn = nth_insn(i);
-        assert(j >= 0 && j < insn.ops.size());
-        return operand_value<OpVal>(insn.ops[j]);
+        return operand_value<OpVal>(insns.oper(i,j));
     }
 
     bap_disasm_op_type oper_type(int i, int j) const {
-        auto insn = nth_insn(i);
-        assert(j >= 0 && j < insn.ops.size());
-        return insn.ops[j].type;
+        return insns.oper(i,j).type;
+    }
+
+    preds_mask satisfied(int n) const {
+        if (insns[n].code == 0)
+            return pred_bit(is_invalid);
+        if (store_preds) {
+            assert(n >= 0 && n < insn_preds.size());
+            return insn_preds[n];
+        }
+        if (n != queue_size() - 1)
+            return 0;
+        return backend_satisfied(supported_predicates);
+    }
+
+    int batch_size() const {
+        return bap_disasm_batch_header +
+            bap_disasm_batch_insn_fields * insns.size() + 1 +
+            bap_disasm_batch_op_fields * insns.operands();
+    }
+
+    // stores the queue in a batch, see disasm.h for the layout.
+    int copy_batch(int64_t *dst, int capacity) {
+        int size = batch_size();
+        if (size > capacity)
+            return size;
+
+        int n = insns.size();
+        int m = insns.operands();
+
+        dst[0] = n;
+        dst[1] = m;
+        int64_t *codes = dst + bap_disasm_batch_header;
+        int64_t *names = codes + n;
+        int64_t *offsets = names + n;
+        int64_t *sizes = offsets + n;
+        int64_t *masks = sizes + n;
+        int64_t *opers = masks + n;
+        int64_t *op_types = opers + n + 1;
+        int64_t *op_values = op_types + m;
+        int64_t *op_names = op_values + m;
+
+        int k = 0;
+        for (int i = 0; i < n; i++) {
+            const queued_insn &insn = insns[i];
+            codes[i] = insn.code;
+            names[i] = insn.name;
+            offsets[i] = insn.loc.off;
+            sizes[i] = insn.loc.len;
+            masks[i] = satisfied(i);
+            opers[i] = k;
+            for (int j = 0; j < insn.ops_size; j++) {
+                const operand &op = insns.oper(i,j);
+                op_types[k] = op.type;
+                op_names[k] = 0;
+                switch (op.type) {
+                case bap_disasm_op_reg:
+                    op_values[k] = op.reg_val.code;
+                    op_names[k] = op.reg_val.name;
+                    break;
+                case bap_disasm_op_imm:
+                    op_values[k] = op.imm_val;
+                    break;
+                case bap_disasm_op_fmm:
+                    std::memcpy(&op_values[k], &op.fmm_val, sizeof(fmm));
+                    break;
+                default:
+                    op_values[k] = 0;
+                }
+                k++;
+            }
+        }
+        opers[n] = k;
+        return size;
     }
 
 private:
+    void clear_asms() {
+        asms.clear();
+        asm_offsets.assign(1, 0);
+    }
+
+    const string &last_asm() {
+        if (!asm_cached) {
+            asm_cache.clear();
+            render_asm(asm_cache);
+            asm_cached = true;
+        }
+        return asm_cache;
+    }
+
+    void render_asm(string &out) {
+        if (stat) {
+            auto start = stat->now();
+            dis->append_asm(out);
+            stat->elapsed(bap_disasm_stat_print_ns, start);
+            stat->count(bap_disasm_stat_asms);
+        } else {
+            dis->append_asm(out);
+        }
+    }
+
+    preds_mask backend_satisfied(preds_mask wanted) const {
+        if (stat) stat->count(bap_disasm_stat_preds);
+        return dis->satisfied(wanted);
+    }
+
+    void decode() {
+        if (stat) {
+            auto start = stat->now();
+            dis->step(base + off);
+            stat->elapsed(bap_disasm_stat_decode_ns, start);
+            stat->count(bap_disasm_stat_insns);
+            if (dis->get_insn().code == 0)
+                stat->count(bap_disasm_stat_invalid);
+        } else {
+            dis->step(base + off);
+        }
+    }
+
     bool step() {
-        dis->step(base + off);
-        auto insn = dis->get_insn();
+        decode();
+        const insn &insn = dis->get_insn();
         off = insn.loc.off + insn.loc.len;
         insns.push_back(insn);
-        asm_cache.clear();
+        asm_cached = false;
 
         if (store_asms) {
-            asms.push_back(dis->get_asm());
+            render_asm(asms);
+            asm_offsets.push_back(asms.size());
         }
 
         if (store_preds) {
-            predicates ps;
-            for (auto p : supported_predicates) {
-                if (dis->satisfies(p))
-                    ps.push_back(p);
-            }
-            insn_preds.push_back(ps);
+            insn_preds.push_back(backend_satisfied(supported_predicates));
         }
 
         if (insn.loc.len == 0) {
             return true;
-        } else if (preds.size() == 0) {
+        } else if (preds == 0) {
             return false;
-        } else if (preds[0] == is_true) {
+        } else if (preds & pred_bit(is_true)) {
             return true;
+        } else if (store_preds) {
+            return insn_preds.back() & preds;
         } else {
-            return std::any_of(preds.begin(), preds.end(), [&](pred p) {
-                    return dis->satisfies(p);
-                });
+            return backend_satisfied(preds);
         }
     }
 };
 
-static vector< shared_ptr<disassembler> > disassemblers;
+// A table of disassembler descriptors.
+//
+// Descriptors are allocated and released under a lock, while lookups
+// are lock free. The table is split into chunks of a fixed size, that
+// are never moved or released, so a slot can be safely read while
+// other threads add new descriptors. A descriptor itself is owned by
+// its creator, and it is the creator's responsibility not to use it
+// concurrently or after it is deleted.
+class handle_table {
+    enum {
+        chunk_bits = 8,
+        chunk_size = 1 << chunk_bits,
+        max_chunks = 4096
+    };
+
+    using slot = std::atomic<disassembler *>;
+
+    std::atomic<slot *> chunks[max_chunks];
+    vector< shared_ptr<disassembler> > owners;
+    vector<int> released;
+    std::mutex lock;
+
+public:
+    handle_table() {
+        for (auto &chunk : chunks)
+            chunk.store(nullptr);
+    }
+
+    ~handle_table() {
+        for (auto &chunk : chunks)
+            delete[] chunk.load();
+    }
+
+    int add(shared_ptr<disassembler> dis) {
+        lock_guard guard(lock);
+        int d;
+        if (!released.empty()) {
+            d = released.back();
+            released.pop_back();
+            owners[d] = dis;
+        } else {
+            d = owners.size();
+            if (d >= chunk_size * max_chunks)
+                return bap_disasm_unknown_error;
+            if (d % chunk_size == 0) {
+                slot *chunk = new slot[chunk_size];
+                for (int i = 0; i < chunk_size; i++)
+                    chunk[i].store(nullptr);
+                chunks[d >> chunk_bits].store(chunk, std::memory_order_release);
+            }
+            owners.push_back(dis);
+        }
+        at(d).store(dis.get(), std::memory_order_release);
+        return d;
+    }
+
+    void remove(int d) {
+        shared_ptr<disassembler> dis;
+        {
+            lock_guard guard(lock);
+            assert(d >= 0 && d < owners.size() && owners[d]);
+            at(d).store(nullptr, std::memory_order_release);
+            dis.swap(owners[d]);
+            released.push_back(d);
+        }
+        // the disassembler is destroyed outside of the critical section
+    }
+
+    disassembler *find(int d) const {
+        assert(d >= 0 && d < chunk_size * max_chunks);
+        const slot *chunk = chunks[d >> chunk_bits].load(std::memory_order_acquire);
+        assert(chunk);
+        return chunk[d & (chunk_size - 1)].load(std::memory_order_acquire);
+    }
+
+private:
+    slot &at(int d) {
+        return chunks[d >> chunk_bits].load()[d & (chunk_size - 1)];
+    }
+};
+
+static handle_table disassemblers;
 
 }
 
@@ -281,39 +716,41 @@ bap_disasm_type bap_disasm_create(const char *backend,
     if (!result.dis)
         return result.err;
 
-    for (int i = 0; i < disassemblers.size(); i++) {
-        if (disassemblers[i] == nullptr) {
-            disassemblers[i] = result.dis;
-            return i;
-        }
-    }
-    disassemblers.push_back(result.dis);
-    return disassemblers.size() - 1;
+    return disassemblers.add(result.dis);
+}
+
+static inline disassembler *get(int d) {
+    auto dis = disassemblers.find(d);
+    assert(dis);
+    return dis;
+}
+
+bap_disasm_type bap_disasm_clone(bap_disasm_type d) {
+    auto result = get(d)->clone();
+
+    if (!result.dis)
+        return result.err;
+
+    return disassemblers.add(result.dis);
 }
 
 void bap_disasm_delete(bap_disasm_type d) {
-    assert(d >= 0 && d < disassemblers.size());
-    disassemblers[d].reset();
+    disassemblers.remove(d);
 }
 
 int bap_disasm_backends_size() {
+    lock_guard guard(backends_lock);
     return backends.size();
 }
 
 const char* bap_disasm_backend_name(int i) {
-    assert(i >=0 && i < bap_disasm_backends_size());
+    lock_guard guard(backends_lock);
+    assert(i >=0 && i < backends.size());
     auto p = backends.cbegin();
     advance(p, i);
     return p->first.c_str();
 }
 
-static inline shared_ptr<disassembler> get(int d) {
-    assert(d >= 0 && d < disassemblers.size());
-    auto dis = disassemblers[d];
-    assert(dis);
-    return dis;
-}
-
 
 void bap_disasm_set_memory(int d, int64_t base, const char *data, int off, int len) {
     get(d)->set_memory(base, data, off, len);
@@ -327,6 +764,31 @@ void bap_disasm_store_asm_strings(int d, int v) {
     get(d)->enable_store_asms(v);
 }
 
+void bap_disasm_set_cache_capacity(int d, int capacity) {
+    get(d)->set_cache_capacity(capacity);
+}
+
+int64_t bap_disasm_cache_hits(int d) {
+    return get(d)->get_cache_stats().hits;
+}
+
+int64_t bap_disasm_cache_misses(int d) {
+    return get(d)->get_cache_stats().misses;
+}
+
+void bap_disasm_stats_enable(int d, int level) {
+    get(d)->enable_stats(level);
+}
+
+void bap_disasm_stats_reset(int d) {
+    get(d)->reset_stats();
+}
+
+int64_t bap_disasm_stats_get(int d, bap_disasm_stat s) {
+    assert(s >= 0 && s < bap_disasm_stats_size);
+    return get(d)->get_stat(s);
+}
+
 const char *bap_disasm_insn_table_ptr(int d) {
     return get(d)->insn_table().data;
 }
@@ -365,18 +827,48 @@ int bap_disasm_offset(int d) {
 }
 
 int bap_disasm_insn_asm_size(int d, int i) {
-    return get(d)->get_asm(i).size();
+    return get(d)->asm_size(i);
 }
 
 void bap_disasm_insn_asm_copy(int d, int i, void *dst) {
-    string s = get(d)->get_asm(i);
-    std::memcpy(dst, &s[0], s.size());
+    auto dis = get(d);
+    std::memcpy(dst, dis->asm_data(i), dis->asm_size(i));
+}
+
+int bap_disasm_asm_arena_copy(int d, char *dst, int capacity) {
+    const string &arena = get(d)->asm_arena();
+    int size = arena.size();
+    if (size <= capacity)
+        std::memcpy(dst, arena.data(), size);
+    return size;
+}
+
+int bap_disasm_asm_index_copy(int d, int32_t *dst, int capacity) {
+    const vector<int> &index = get(d)->asm_index();
+    int size = index.size();
+    if (size <= capacity)
+        std::copy(index.begin(), index.end(), dst);
+    return size;
 }
 
 void bap_disasm_run(int d) {
     get(d)->run();
 }
 
+int bap_disasm_run_batch(int d, int64_t *dst, int capacity) {
+    disassembler *dis = get(d);
+    dis->run();
+    return dis->copy_batch(dst, capacity);
+}
+
+int bap_disasm_batch_size(int d) {
+    return get(d)->batch_size();
+}
+
+int bap_disasm_batch_copy(int d, int64_t *dst, int capacity) {
+    return get(d)->copy_batch(dst, capacity);
+}
+
 void bap_disasm_insns_clear(int d) {
     get(d)->clear_insns();
 }
@@ -385,7 +877,7 @@ int bap_disasm_insns_size(int d) {
     return get(d)->queue_size();
 }
 
-static inline const insn &get_insn(int d, int i) {
+static inline const queued_insn &get_insn(int d, int i) {
     return get(d)->nth_insn(i);
 }
 
@@ -410,7 +902,7 @@ int bap_disasm_insn_satisfies(int d, int i, bap_disasm_insn_p_type p) {
 }
 
 int bap_disasm_insn_ops_size(int d, int i) {
-    return get_insn(d,i).ops.size();
+    return get_insn(d,i).ops_size;
 }
 
 bap_disasm_op_type bap_disasm_insn_op_type(int d, int i, int j) {
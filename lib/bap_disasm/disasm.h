@@ -63,6 +63,14 @@
  *
  *  One of the precondition that hold for all function, is that argument
  *  of type bap_disasm_type  should be valid.
+ *
+ *  Threads:
+ *
+ *  Disassemblers can be created, cloned and deleted concurrently from
+ *  different threads. A disassembler descriptor is owned by its
+ *  creator, and different disassemblers can be used at the same time
+ *  from different threads, but the same disassembler should not be
+ *  used by two threads at once.
  */
 
 
@@ -109,9 +117,58 @@ typedef enum bap_disasm_insn_p {
     may_load
 } bap_disasm_insn_p_type;
 
+/** disassembler statistics, see bap_disasm_stats_enable  */
+typedef enum bap_disasm_stat {
+    bap_disasm_stat_insns,          /* instructions decoded */
+    bap_disasm_stat_invalid,        /* invalid instructions */
+    bap_disasm_stat_preds,          /* predicates evaluated by a backend */
+    bap_disasm_stat_asms,           /* assembly strings rendered */
+    bap_disasm_stat_decode_ns,      /* nanoseconds spent in decoding */
+    bap_disasm_stat_print_ns,       /* nanoseconds spent in rendering */
+    bap_disasm_stat_cycles,         /* CPU cycles spent in runs */
+    bap_disasm_stat_cache_misses,   /* CPU cache misses in runs */
+    bap_disasm_stats_size
+} bap_disasm_stat;
+
+/** Batch layout.
+ *
+ * A batch is a flat array of int64_t words, that contains the whole
+ * instruction queue laid out as a struct of arrays. For a queue of N
+ * instructions, that have M operands in total, the layout is:
+ *
+ *  [0]                   N
+ *  [1]                   M
+ *  codes[N]              instruction codes
+ *  names[N]              offsets in the instruction name table
+ *  offsets[N]            offsets of instructions in the memory region
+ *  sizes[N]              sizes of instructions in bytes
+ *  preds[N]              predicate masks, bit p is set if an
+ *                        instruction satisfies predicate p
+ *  opers[N+1]            operands of instruction i are in the range
+ *                        [opers[i], opers[i+1]) of the operand slab
+ *  op_types[M]           operand types (bap_disasm_op_type)
+ *  op_values[M]          register code, immediate value, or bits
+ *                        of a floating point immediate value
+ *  op_names[M]           offsets of register names in the register
+ *                        name table, or 0 for non register operands
+ *
+ * The total size of a batch is (bap_disasm_batch_header +
+ * bap_disasm_batch_insn_fields * N + 1 + bap_disasm_batch_op_fields * M)
+ * words.
+ *
+ * Predicate masks follow the same rules as bap_disasm_insn_satisfies,
+ * i.e., unless the store_predicates option is enabled, only the last
+ * instruction has a full mask, and other instructions has only the
+ * is_invalid bit set (if they are invalid).
+ */
+enum {
+    bap_disasm_batch_header = 2,
+    bap_disasm_batch_insn_fields = 6,
+    bap_disasm_batch_op_fields = 3,
+};
+
 /** bap_disasm_create(triple,cpu) creates a disassembler for a given
  * triple and cpu.
- * This function is not thread safe.
  * @pre No preconditions. In case of error the corresponding code is returned. */
 bap_disasm_type bap_disasm_create(
     const char *backend,
@@ -119,9 +176,18 @@ bap_disasm_type bap_disasm_create(
     const char *cpu,
     int debug_level);
 
+/** bap_disasm_clone(disasm) creates a new disassembler for the same
+ * backend, triple and cpu as \a disasm. The new disassembler reuses
+ * the target description of the original one, so cloning is much
+ * cheaper than creation. The clone has an empty queue, an empty set
+ * of predicates, no memory, and all options are in their default
+ * state.
+ * @pre disasm is valid descriptor. In case of error the corresponding
+ * code is returned. */
+bap_disasm_type bap_disasm_clone(bap_disasm_type disasm);
+
 /** deletes disassembler \a disasm.
- * This function is not thread safe.
- * @pre disasm is valid descriptor */
+ * @pre disasm is valid descriptor and is not used by other threads */
 void bap_disasm_delete(bap_disasm_type disasm);
 
 /** returns total amount of registered backends */
@@ -170,6 +236,40 @@ void bap_disasm_store_predicates(bap_disasm_type disasm, int enable);
 void bap_disasm_store_asm_strings(bap_disasm_type disasm, int enable);
 
 
+/* enables a cache of decoded instructions, so that an instruction,
+ * that is disassembled again from the same bytes at the same address,
+ * is not decoded twice. The cache holds up to \a capacity
+ * instructions, when it is full new instructions are not added.
+ * Zero capacity disables the cache and releases all its entries.
+ * By default the cache is disabled.
+ * @pre capacity >= 0
+ */
+void bap_disasm_set_cache_capacity(bap_disasm_type disasm, int capacity);
+
+/* returns the number of steps, that were served from the cache  */
+int64_t bap_disasm_cache_hits(bap_disasm_type disasm);
+
+/* returns the number of steps, that were decoded while the cache was
+ * enabled */
+int64_t bap_disasm_cache_misses(bap_disasm_type disasm);
+
+/* enables collection of statistics, if \a level is greater than 0,
+ * or disables it. With level 1 the disassembler counts events and
+ * measures time spent in the backend, with level 2 it also reads CPU
+ * cycles and cache misses from hardware performance counters, if
+ * they are available (on Linux with perf events enabled), otherwise
+ * the latter are zero. Hardware counters measure the thread that
+ * enabled them. Statistics are disabled by default.
+ */
+void bap_disasm_stats_enable(bap_disasm_type disasm, int level);
+
+/* resets all statistics to zero */
+void bap_disasm_stats_reset(bap_disasm_type disasm);
+
+/* returns the value of the statistic \a stat.
+ * @pre stat < bap_disasm_stats_size */
+int64_t bap_disasm_stats_get(bap_disasm_type disasm, bap_disasm_stat stat);
+
 /* returns a pointer to an instruction name table.
  * The table is created with a disassembler and never changes afterwards.
 * It contains a set of null-terminated strings
@@ -232,7 +332,34 @@ int bap_disasm_offset(bap_disasm_type disasm);
  */
 void bap_disasm_run(bap_disasm_type disasm);
 
-/* clears instruction queue and all assosiated data
+/* runs disassembler in the same way as bap_disasm_run, and stores
+ * the whole instruction queue into the batch \a dst, if it fits into
+ * \a capacity words. Returns the size of the batch in words, so that
+ * if it is greater than \a capacity, then nothing was written and
+ * the queue can be retrieved with bap_disasm_batch_copy into a
+ * sufficiently large buffer.
+ *
+ * @pre capacity >= 0
+ * @pre memory region (dst, dst+capacity-1) is writable by a process.
+ * @post insn_size is increased by one.
+ */
+int bap_disasm_run_batch(bap_disasm_type disasm, int64_t *dst, int capacity);
+
+/* returns the size in words of a batch, that holds the current
+ * instruction queue.
+ * @pre none
+ */
+int bap_disasm_batch_size(bap_disasm_type disasm);
+
+/* stores the instruction queue into the batch \a dst, if it fits
+ * into \a capacity words. Returns the size of the batch.
+ * @pre the same as in bap_disasm_run_batch
+ */
+int bap_disasm_batch_copy(bap_disasm_type disasm, int64_t *dst, int capacity);
+
+/* clears instruction queue and all assosiated data. The memory
+ * occupied by the queue is retained for the following runs, so this
+ * operation takes constant time.
  * @pre none
  * @post instruction queue is empty
  */
@@ -282,6 +409,23 @@ int bap_disasm_insn_asm_size(bap_disasm_type disasm, int insn);
  */
 void bap_disasm_insn_asm_copy(bap_disasm_type disasm, int insn, void *dst);
 
+/* Assembly strings of all queued instructions are stored in a single
+ * arena, when the store_asm_strings option is enabled. The string of
+ * the instruction i occupies the range [index[i], index[i+1]) of the
+ * arena, so the index of a queue of N instructions has N+1 entries.
+ * Strings are not null-terminated.
+ */
+
+/* copies the arena to \a dst if it has enough capacity, and returns
+ * the size of the arena in bytes.
+ * @pre store_asm_strings option is enabled */
+int bap_disasm_asm_arena_copy(bap_disasm_type disasm, char *dst, int capacity);
+
+/* copies the index of the arena to \a dst if it has enough capacity,
+ * and returns the number of entries in the index.
+ * @pre store_asm_strings option is enabled */
+int bap_disasm_asm_index_copy(bap_disasm_type disasm, int32_t *dst, int capacity);
+
 /* returns non zero if instruction satisfies predicate.
  * @pre not satisfies(insn, is_invalid)
  * @pre is_supported(p)
@@ -293,6 +437,7 @@ int bap_disasm_insn_satisfies(bap_disasm_type disasm,
                               bap_disasm_insn_p_type p);
 
 
+
 /* Quering operands
  *
  * All functions below share precondition that op is less than
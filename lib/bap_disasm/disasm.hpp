@@ -1,6 +1,7 @@
 #include <vector>
 #include <memory>
 #include <set>
+#include <cstdint>
 
 extern "C" {
     #include "disasm.h"
@@ -13,6 +14,19 @@ struct insn;
 struct location;
 struct operand;
 
+// a set of predicates, where predicate p is represented by the
+// bit (1 << p).
+typedef uint16_t preds_mask;
+
+inline preds_mask pred_bit(bap_disasm_insn_p_type p) {
+    return 1 << p;
+}
+
+struct cache_stats {
+    int64_t hits;
+    int64_t misses;
+};
+
 
 
 // An interface that should be implemented by a backend.
@@ -48,17 +62,35 @@ struct disassembler_interface {
     // each name is a null-terminated string.
     virtual table reg_table() const = 0;
 
-    // returns last disassembled instruction
-    virtual insn get_insn() const = 0;
+    // returns last disassembled instruction. The reference is valid
+    // until the next step.
+    virtual const insn &get_insn() const = 0;
 
-    // returns a disassembly string of a current instruction.
-    virtual std::string get_asm() const = 0;
+    // appends a disassembly string of a current instruction to \a out.
+    virtual void append_asm(std::string &out) const = 0;
 
     // true if insn satisifes predicate \a p.
     virtual bool satisfies(bap_disasm_insn_p_type p) const = 0;
 
+    // a subset of predicates in \a wanted, that are satisfied by the
+    // insn. Predicates, that are not wanted, need not be computed.
+    virtual preds_mask satisfied(preds_mask wanted) const = 0;
+
     // returns a set of predicates supported by this disassmbler.
     virtual bool supports(bap_disasm_insn_p_type p) const = 0;
+
+    // creates a new disassembler for the same target, that has its
+    // own state, but may share immutable target descriptions with
+    // this one, so that both can be used from different threads.
+    // Returns nullptr if the operation is not possible.
+    virtual std::shared_ptr<disassembler_interface> clone() const = 0;
+
+    // enables a cache of decoded instructions, that can hold up to
+    // \a capacity entries. Zero capacity disables and clears the cache.
+    virtual void set_cache_capacity(std::size_t capacity) = 0;
+
+    // returns the numbers of cache hits and misses.
+    virtual cache_stats get_cache_stats() const = 0;
 };
 
 struct reg {
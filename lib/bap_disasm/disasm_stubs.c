@@ -3,8 +3,10 @@
 #include <caml/bigarray.h>
 #include <caml/alloc.h>
 #include <assert.h>
+#include <unistd.h>
 
 #include "disasm.h"
+#include "x86_length.h"
 
 
 /* noalloc */
@@ -64,6 +66,40 @@ value bap_disasm_store_asm_strings_stub(value d, value b) {
     return Val_unit;
 }
 
+/* noalloc */
+value bap_disasm_set_cache_capacity_stub(value d, value n) {
+    bap_disasm_set_cache_capacity(Int_val(d), Int_val(n));
+    return Val_unit;
+}
+
+/* noalloc */
+value bap_disasm_cache_hits_stub(value d) {
+    return Val_long(bap_disasm_cache_hits(Int_val(d)));
+}
+
+/* noalloc */
+value bap_disasm_cache_misses_stub(value d) {
+    return Val_long(bap_disasm_cache_misses(Int_val(d)));
+}
+
+/* noalloc */
+value bap_disasm_stats_enable_stub(value d, value level) {
+    bap_disasm_stats_enable(Int_val(d), Int_val(level));
+    return Val_unit;
+}
+
+/* noalloc */
+value bap_disasm_stats_reset_stub(value d) {
+    bap_disasm_stats_reset(Int_val(d));
+    return Val_unit;
+}
+
+/* noalloc */
+value bap_disasm_stats_get_stub(value d, value s) {
+    return Val_long(bap_disasm_stats_get(Int_val(d),
+                                         (bap_disasm_stat)Int_val(s)));
+}
+
 /* alloc */
 value bap_disasm_insn_table_stub(value d) {
     CAMLparam1(d);
@@ -119,6 +155,37 @@ value bap_disasm_run_stub(value d) {
     return Val_unit;
 }
 
+#define Batch_data_val(b) (int64_t *)Caml_ba_data_val(b)
+#define Batch_capacity_val(b) (int)Caml_ba_array_val(b)->dim[0]
+
+/* noalloc */
+value bap_disasm_run_batch_stub(value d, value batch) {
+    return Val_int(bap_disasm_run_batch(Int_val(d),
+                                        Batch_data_val(batch),
+                                        Batch_capacity_val(batch)));
+}
+
+/* noalloc */
+value bap_disasm_batch_copy_stub(value d, value batch) {
+    return Val_int(bap_disasm_batch_copy(Int_val(d),
+                                         Batch_data_val(batch),
+                                         Batch_capacity_val(batch)));
+}
+
+/* noalloc */
+value bap_disasm_asm_arena_copy_stub(value d, value arena) {
+    return Val_int(bap_disasm_asm_arena_copy(Int_val(d),
+                                             (char *)Caml_ba_data_val(arena),
+                                             Caml_ba_array_val(arena)->dim[0]));
+}
+
+/* noalloc */
+value bap_disasm_asm_index_copy_stub(value d, value index) {
+    return Val_int(bap_disasm_asm_index_copy(Int_val(d),
+                                             (int32_t *)Caml_ba_data_val(index),
+                                             Caml_ba_array_val(index)->dim[0]));
+}
+
 /* noalloc */
 value bap_disasm_insns_clear_stub(value d) {
     bap_disasm_insns_clear(Int_val(d));
@@ -212,3 +279,20 @@ value bap_disasm_insn_op_fmm_value_stub(value d, value i, value j) {
     CAMLreturn(caml_copy_double
                (bap_disasm_insn_op_fmm_value(Int_val(d), Int_val(i), Int_val(j))));
 }
+
+/* noalloc */
+value bap_disasm_x86_lengths_stub(value data, value off, value len,
+                                  value is64, value offsets) {
+    return Val_int(bap_disasm_x86_lengths
+                   ((const uint8_t *)Caml_ba_data_val(data) + Int_val(off),
+                    Int_val(len),
+                    Bool_val(is64),
+                    (int32_t *)Caml_ba_data_val(offsets),
+                    Caml_ba_array_val(offsets)->dim[0]));
+}
+
+/* noalloc, terminates the process without running at_exit
+   handlers and flushing channels, inherited from the parent */
+value bap_disasm_exit_stub(value code) {
+    _exit(Int_val(code));
+}
@@ -0,0 +1,267 @@
+#include <algorithm>
+
+#include "x86_length.hpp"
+
+namespace bap { namespace x86 {
+
+namespace {
+
+const std::size_t max_length = 15;
+
+// properties of an opcode, that define the length of an instruction
+enum : uint16_t {
+    modrm  = 1 << 0,            // has ModRM byte
+    imm8   = 1 << 1,
+    imm16  = 1 << 2,
+    immz   = 1 << 3,            // 16 or 32 bits, by the operand size
+    immv   = 1 << 4,            // 16, 32 or 64 bits, by the operand size
+    moffs  = 1 << 5,            // 16, 32 or 64 bits, by the address size
+    rel    = 1 << 6,            // like immz, but always 32 bits in 64-bit mode
+    group3 = 1 << 7,            // only TEST (reg = 0, 1) has an immediate
+    bad64  = 1 << 8,            // invalid in 64-bit mode
+    imm32  = 1 << 9,
+};
+
+struct tables {
+    bool prefix[256];
+    uint16_t one[256];
+    uint16_t two[256];
+
+    tables() {
+        std::fill(prefix, prefix + 256, false);
+        std::fill(one, one + 256, 0);
+        std::fill(two, two + 256, modrm);
+
+        for (uint8_t b : {0x26, 0x2e, 0x36, 0x3e, 0x64, 0x65,
+                    0x66, 0x67, 0xf0, 0xf2, 0xf3})
+            prefix[b] = true;
+
+        // ALU operations: r/m,r; r,r/m; al,ib; eax,iz
+        for (int row = 0; row < 0x40; row += 8) {
+            std::fill(one + row, one + row + 4, modrm);
+            one[row + 4] = imm8;
+            one[row + 5] = immz;
+        }
+        for (uint8_t b : {0x06, 0x07, 0x0e, 0x16, 0x17, 0x1e, 0x1f,
+                    0x27, 0x2f, 0x37, 0x3f, 0x60, 0x61, 0xce, 0xd6})
+            one[b] = bad64;
+
+        one[0x62] = modrm | bad64;
+        one[0x63] = modrm;
+        one[0x68] = immz;
+        one[0x69] = modrm | immz;
+        one[0x6a] = imm8;
+        one[0x6b] = modrm | imm8;
+        std::fill(one + 0x70, one + 0x80, imm8);
+        one[0x80] = modrm | imm8;
+        one[0x81] = modrm | immz;
+        one[0x82] = modrm | imm8 | bad64;
+        one[0x83] = modrm | imm8;
+        std::fill(one + 0x84, one + 0x90, modrm);
+        one[0x9a] = immz | imm16 | bad64;
+        std::fill(one + 0xa0, one + 0xa4, moffs);
+        one[0xa8] = imm8;
+        one[0xa9] = immz;
+        std::fill(one + 0xb0, one + 0xb8, imm8);
+        std::fill(one + 0xb8, one + 0xc0, immv);
+        one[0xc0] = modrm | imm8;
+        one[0xc1] = modrm | imm8;
+        one[0xc2] = imm16;
+        one[0xc4] = modrm | bad64;
+        one[0xc5] = modrm | bad64;
+        one[0xc6] = modrm | imm8;
+        one[0xc7] = modrm | immz;
+        one[0xc8] = imm16 | imm8;
+        one[0xca] = imm16;
+        one[0xcd] = imm8;
+        std::fill(one + 0xd0, one + 0xd4, modrm);
+        one[0xd4] = imm8 | bad64;
+        one[0xd5] = imm8 | bad64;
+        std::fill(one + 0xd8, one + 0xe0, modrm);
+        std::fill(one + 0xe0, one + 0xe8, imm8);
+        one[0xe8] = rel;
+        one[0xe9] = rel;
+        one[0xea] = immz | imm16 | bad64;
+        one[0xeb] = imm8;
+        one[0xf6] = modrm | imm8 | group3;
+        one[0xf7] = modrm | immz | group3;
+        one[0xfe] = modrm;
+        one[0xff] = modrm;
+
+        for (uint8_t b : {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+                    0x0b, 0x0c, 0x0e, 0x39, 0x3b, 0x3c, 0x3d, 0x3e,
+                    0x3f, 0x77, 0xa0, 0xa1, 0xa2, 0xa8, 0xa9, 0xaa})
+            two[b] = 0;
+        std::fill(two + 0x30, two + 0x38, 0);
+        std::fill(two + 0x80, two + 0x90, rel);
+        std::fill(two + 0xc8, two + 0xd0, 0);
+        for (uint8_t b : {0x0f, 0x70, 0x71, 0x72, 0x73, 0xa4, 0xac,
+                    0xba, 0xc2, 0xc4, 0xc5, 0xc6})
+            two[b] = modrm | imm8;
+    }
+};
+
+const tables& opcodes() {
+    static const tables t;
+    return t;
+}
+
+struct decoder {
+    decoder(const uint8_t *data, std::size_t size, bool is64)
+        : p(data)
+        , size(size)
+        , n(std::min(size, max_length))
+        , is64(is64) {}
+
+    std::size_t run() {
+        const tables &t = opcodes();
+        while (i < n && (t.prefix[p[i]] || is_rex(p[i]))) {
+            uint8_t b = p[i++];
+            // a legacy prefix cancels a preceding REX prefix
+            rex_w = is_rex(b) && (b & 0x08);
+            if (b == 0x66) opsize16 = true;
+            if (b == 0x67) addrsize = true;
+        }
+        if (i == n) return fail();
+        uint8_t op = p[i++];
+        if (op == 0x0f) return two_byte(t);
+        if (is_vex(op)) return vex(t, op);
+        if (is64 && (t.one[op] & bad64)) return 1;
+        return operands(t.one[op]);
+    }
+
+private:
+    bool is_rex(uint8_t b) const { return is64 && (b & 0xf0) == 0x40; }
+
+    // C4, C5 (LES, LDS), 62 (BOUND) and 8F (POP) are reused by
+    // VEX, EVEX, and XOP, that are told apart by the next byte.
+    bool is_vex(uint8_t op) const {
+        if (i == n) return false;
+        uint8_t next = p[i];
+        switch (op) {
+        case 0xc4: case 0xc5: case 0x62:
+            return is64 || (next & 0xc0) == 0xc0;
+        case 0x8f:
+            return (next & 0x1f) >= 8;
+        default:
+            return false;
+        }
+    }
+
+    // the instruction doesn't fit into the data, or is too long
+    std::size_t fail() const { return size < max_length ? 0 : 1; }
+
+    std::size_t address_bits() const {
+        if (is64) return addrsize ? 32 : 64;
+        return addrsize ? 16 : 32;
+    }
+
+    std::size_t two_byte(const tables &t) {
+        if (i == n) return fail();
+        uint8_t op = p[i++];
+        if (op == 0x38 || op == 0x3a) {
+            if (i == n) return fail();
+            ++i;
+            return operands(op == 0x38 ? modrm : modrm | imm8);
+        }
+        return operands(t.two[op]);
+    }
+
+    std::size_t vex(const tables &t, uint8_t op) {
+        std::size_t payload = op == 0xc5 ? 1 : op == 0x62 ? 3 : 2;
+        uint8_t map = op == 0xc5 ? 1 :
+            op == 0x62 ? p[i] & 0x03 : p[i] & 0x1f;
+        i += payload;
+        if (i >= n) return fail();
+        uint8_t code = p[i++];
+        switch (map) {
+        case 1:
+            if (op != 0x62 && code == 0x77) // VZEROUPPER, VZEROALL
+                return i;
+            return operands(modrm | (t.two[code] & imm8));
+        case 2: case 9:
+            return operands(modrm);
+        case 3: case 8:
+            return operands(modrm | imm8);
+        case 0xa:
+            return operands(modrm | imm32);
+        default:
+            return 1;
+        }
+    }
+
+    bool skip_modrm(uint8_t &reg) {
+        if (i == n) return false;
+        uint8_t m = p[i++];
+        uint8_t mod = m >> 6, rm = m & 7;
+        reg = (m >> 3) & 7;
+        if (mod == 3) return true;
+        std::size_t disp = 0;
+        if (address_bits() == 16) {
+            if ((mod == 0 && rm == 6) || mod == 2) disp = 2;
+            if (mod == 1) disp = 1;
+        } else {
+            if (rm == 4) {
+                if (i == n) return false;
+                if (mod == 0 && (p[i] & 7) == 5) disp = 4;
+                ++i;
+            }
+            if ((mod == 0 && rm == 5) || mod == 2) disp = 4;
+            if (mod == 1) disp = 1;
+        }
+        i += disp;
+        return i <= n;
+    }
+
+    std::size_t operands(uint16_t flags) {
+        uint8_t reg = 0;
+        if ((flags & modrm) && !skip_modrm(reg))
+            return fail();
+        std::size_t z = rex_w || !opsize16 ? 4 : 2;
+        std::size_t imm = 0;
+        if (flags & imm8) imm += 1;
+        if (flags & imm16) imm += 2;
+        if (flags & imm32) imm += 4;
+        if (flags & immz) imm += z;
+        if (flags & immv) imm += rex_w ? 8 : z;
+        if (flags & moffs) imm += address_bits() / 8;
+        if (flags & rel) imm += is64 ? 4 : z;
+        if ((flags & group3) && reg > 1) imm = 0;
+        i += imm;
+        return i <= n ? i : fail();
+    }
+
+    const uint8_t *p;
+    std::size_t size;
+    std::size_t n;
+    bool is64;
+    std::size_t i = 0;
+    bool opsize16 = false;
+    bool addrsize = false;
+    bool rex_w = false;
+};
+
+} // namespace
+
+std::size_t insn_length(const uint8_t *data, std::size_t size, bool is64) {
+    return decoder(data, size, is64).run();
+}
+
+}} // namespace bap::x86
+
+int bap_disasm_x86_lengths(const uint8_t *data, int size, int is64,
+                           int32_t *offsets, int capacity) {
+    int count = 0;
+    int offset = 0;
+    while (count < capacity) {
+        offsets[count++] = offset;
+        if (offset >= size)
+            break;
+        std::size_t len =
+            bap::x86::insn_length(data + offset, size - offset, is64);
+        if (len == 0)
+            break;
+        offset += len;
+    }
+    return count;
+}
@@ -0,0 +1,33 @@
+#ifndef BAP_X86_LENGTH_H
+#define BAP_X86_LENGTH_H
+
+#include <stdint.h>
+
+/** x86 instruction length decoder.
+ *
+ *  Finds instruction boundaries of x86 and x86-64 code without
+ *  decoding instructions, using only the prefix, opcode and ModRM
+ *  tables. It is much faster than a disassembler, and can be used
+ *  for a quick linear sweep, with the full decoding done later only
+ *  for instructions of interest.
+ *
+ *  Bytes that do not start a valid instruction are treated as a
+ *  one-byte instruction, like a disassembler treats an invalid
+ *  instruction.
+ */
+
+/** [bap_disasm_x86_lengths(data, size, is64, offsets, capacity)]
+ *  sweeps [size] bytes of [data] in 64-bit mode if [is64] is not
+ *  zero and in 32-bit mode otherwise.
+ *
+ *  Stores offsets of the first [capacity] instructions in [offsets]
+ *  and returns the number of stored offsets. The offset of the
+ *  instruction [i] is [offsets[i]], and its length is
+ *  [offsets[i+1] - offsets[i]]. If less than [capacity] offsets were
+ *  stored, then the last one is the end of the sweep. The sweep
+ *  stops before an instruction that doesn't fit into [data].
+ */
+int bap_disasm_x86_lengths(const uint8_t *data, int size, int is64,
+                           int32_t *offsets, int capacity);
+
+#endif /* BAP_X86_LENGTH_H */
@@ -0,0 +1,20 @@
+#ifndef BAP_X86_LENGTH_HPP
+#define BAP_X86_LENGTH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+    #include "x86_length.h"
+}
+
+namespace bap { namespace x86 {
+
+// the length of an instruction that starts at [data], 1 if the
+// bytes do not start a valid instruction, or 0 if the instruction
+// doesn't fit into [size] bytes.
+std::size_t insn_length(const uint8_t *data, std::size_t size, bool is64);
+
+}} // namespace bap::x86
+
+#endif // BAP_X86_LENGTH_HPP
@@ -12,8 +12,8 @@ let mapfile path : Bigstring.t option =
     Unix.close fd;
     None
 
-let readfile path : Bigstring.t =
-  match mapfile path with
+let readfile ?(mmap=true) path : Bigstring.t =
+  match if mmap then mapfile path else None with
   | Some data -> data
   | None -> Bigstring.of_string (In_channel.read_all path)
 
@@ -3,6 +3,10 @@
 open Core_kernel.Std
 open Bap_types.Std
 
-val readfile : string -> Bigstring.t
+(** [readfile ?mmap path] returns the contents of the file at [path].
+    If [mmap] is [true] (the default), then the file is mapped into
+    memory instead of being read, falling back to reading if the
+    mapping fails. *)
+val readfile : ?mmap:bool -> string -> Bigstring.t
 
 val parse_name : string -> (string * string option) option
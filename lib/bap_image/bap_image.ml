@@ -305,8 +305,8 @@ let of_bigstring ?backend data =
 let of_string ?backend data =
   of_bigstring ?backend (Bigstring.of_string data)
 
-let create ?(backend="llvm") path : result =
-  try_with (fun () -> Bap_fileutils.readfile path) >>= fun data ->
+let create ?(backend="llvm") ?mmap path : result =
+  try_with (fun () -> Bap_fileutils.readfile ?mmap path) >>= fun data ->
   if backend = "auto" then autoload data (Some path)
   else of_backend backend data (Some path)
 
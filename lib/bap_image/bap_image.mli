@@ -14,7 +14,7 @@ type path = string
 
 type result = (t * Error.t list) Or_error.t
 
-val create : ?backend:string -> path -> result
+val create : ?backend:string -> ?mmap:bool -> path -> result
 val of_string : ?backend:string -> string -> result
 val of_bigstring : ?backend:string -> Bigstring.t -> result
 
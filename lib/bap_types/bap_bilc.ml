@@ -0,0 +1,245 @@
+open Core_kernel.Std
+open Bap_common
+open Bap_bil
+open Bap_result
+
+module Var = Bap_var
+
+(* The register file. Each variable, that occurs in a compiled program,
+   is assigned a slot, and compiled code accesses it directly. Slots
+   are assigned at compile time, so the [regs] array may grow only
+   during compilation. *)
+type t = {
+  slots : int Var.Table.t;
+  mutable regs : value array;
+  mutable pc : value;
+}
+
+type program = unit -> unit
+
+let create () = {
+  slots = Var.Table.create ();
+  regs = Array.create ~len:64 Bot;
+  pc = Bot;
+}
+
+let slot t var = match Var.Table.find t.slots var with
+  | Some i -> i
+  | None ->
+    let i = Var.Table.length t.slots in
+    Var.Table.set t.slots ~key:var ~data:i;
+    let len = Array.length t.regs in
+    if i >= len then begin
+      let regs = Array.create ~len:(2 * len) Bot in
+      Array.blit ~src:t.regs ~src_pos:0 ~dst:regs ~dst_pos:0 ~len;
+      t.regs <- regs
+    end;
+    i
+
+let lookup t var = match Var.Table.find t.slots var with
+  | Some i -> t.regs.(i)
+  | None -> Bot
+
+let update t var x = t.regs.(slot t var) <- x
+let pc t = t.pc
+let with_pc t pc = t.pc <- pc
+
+let bindings t =
+  Var.Table.to_alist t.slots |>
+  Sequence.of_list |>
+  Sequence.filter_map ~f:(fun (var,i) -> match t.regs.(i) with
+      | Bot -> None
+      | x -> Some (var,x))
+
+(* The semantics follows the [Bap_expi] and [Bap_bili] interpreters
+   with their default behavior, i.e., all errors evaluate to [Bot]. *)
+
+let binop op : word -> word -> word =
+  let open Bitvector in
+  match op with
+  | Binop.PLUS -> (+)
+  | Binop.MINUS -> (-)
+  | Binop.TIMES -> ( * )
+  | Binop.DIVIDE -> (/)
+  | Binop.SDIVIDE -> fun u v -> signed u / signed v
+  | Binop.MOD -> (mod)
+  | Binop.SMOD -> fun u v -> signed u mod signed v
+  | Binop.LSHIFT -> (lsl)
+  | Binop.RSHIFT -> (lsr)
+  | Binop.ARSHIFT -> (asr)
+  | Binop.AND -> (land)
+  | Binop.OR -> (lor)
+  | Binop.XOR -> (lxor)
+  | Binop.EQ -> fun u v -> of_bool (u = v)
+  | Binop.NEQ -> fun u v -> of_bool (u <> v)
+  | Binop.LT -> fun u v -> of_bool (u < v)
+  | Binop.LE -> fun u v -> of_bool (u <= v)
+  | Binop.SLT -> fun u v -> of_bool (signed u < signed v)
+  | Binop.SLE -> fun u v -> of_bool (signed u <= signed v)
+
+let unop op : word -> word = match op with
+  | Unop.NEG -> Bitvector.neg
+  | Unop.NOT -> Bitvector.lnot
+
+let cast ct sz u : word option =
+  let open Bitvector in
+  try Option.return @@ match ct with
+    | Cast.UNSIGNED -> extract_exn ~hi:Int.(sz - 1) u
+    | Cast.SIGNED   -> extract_exn ~hi:Int.(sz - 1) (signed u)
+    | Cast.HIGH     -> extract_exn ~lo:Int.(bitwidth u - sz) u
+    | Cast.LOW      -> extract_exn ~hi:Int.(sz - 1) u
+  with exn -> None
+
+let concat u w = match u,w with
+  | Imm u, Imm w -> Imm (Bitvector.concat u w)
+  | _ -> Bot
+
+let rec load_word mem addr endian size =
+  let v = match mem#load addr with
+    | Some w -> Imm w
+    | None -> Bot in
+  if size = 8 then v else
+    let u = load_word mem (Bitvector.succ addr) endian (size - 8) in
+    match endian with
+    | LittleEndian -> concat u v
+    | BigEndian    -> concat v u
+
+let rec store_word mem addr word endian size =
+  let hd_ct,tl_ct = match endian with
+    | LittleEndian -> Cast.(LOW,HIGH)
+    | BigEndian    -> Cast.(HIGH,LOW) in
+  match cast hd_ct 8 word with
+  | None -> Bot
+  | Some hd ->
+    let mem = mem#save addr hd in
+    if size = 8 then Mem mem
+    else match cast tl_ct (size - 8) word with
+      | Some tl -> store_word mem (Bitvector.succ addr) tl endian (size - 8)
+      | None -> Bot
+
+let is_true = function
+  | Imm r -> Bitvector.(r = b1)
+  | _ -> false
+
+let is_false = function
+  | Imm r -> Bitvector.(r = b0)
+  | _ -> false
+
+let rec exp t e : unit -> value = match e with
+  | Exp.Var v ->
+    let i = slot t v in
+    fun () -> t.regs.(i)
+  | Exp.Int w ->
+    let x = Imm w in
+    fun () -> x
+  | Exp.Load (mem,addr,endian,sz) ->
+    let mem = exp t mem and addr = exp t addr in
+    let size = Bap_size.in_bits sz in
+    fun () -> begin match addr () with
+      | Imm addr -> begin match mem () with
+          | Mem mem -> load_word mem addr endian size
+          | _ -> Bot
+        end
+      | _ -> Bot
+    end
+  | Exp.Store (mem,addr,word,endian,sz) ->
+    let mem = exp t mem and addr = exp t addr and word = exp t word in
+    let size = Bap_size.in_bits sz in
+    fun () -> begin match word () with
+      | Imm word -> begin match addr () with
+          | Imm addr -> begin match mem () with
+              | Bot -> store_word (new Storage.sparse) addr word endian size
+              | Mem mem -> store_word mem addr word endian size
+              | Imm _ -> Bot
+            end
+          | _ -> Bot
+        end
+      | _ -> Bot
+    end
+  | Exp.BinOp (op,x,y) ->
+    let f = binop op and x = exp t x and y = exp t y in
+    fun () -> begin match x (), y () with
+      | Imm u, Imm v ->
+        begin
+          try Imm (f u v)
+          with Bitvector.Width | Division_by_zero -> Bot
+        end
+      | _ -> Bot
+    end
+  | Exp.UnOp (op,x) ->
+    let f = unop op and x = exp t x in
+    fun () -> begin match x () with
+      | Imm u -> Imm (f u)
+      | _ -> Bot
+    end
+  | Exp.Cast (ct,sz,x) ->
+    let x = exp t x in
+    fun () -> begin match x () with
+      | Imm u -> Option.value_map (cast ct sz u) ~default:Bot ~f:(fun r -> Imm r)
+      | _ -> Bot
+    end
+  | Exp.Let (v,x,body) ->
+    let i = slot t v and x = exp t x and body = exp t body in
+    fun () ->
+      let u = x () in
+      let w = t.regs.(i) in
+      t.regs.(i) <- u;
+      let r = body () in
+      t.regs.(i) <- w;
+      r
+  | Exp.Unknown _ -> fun () -> Bot
+  | Exp.Ite (cond,yes,no) ->
+    let cond = exp t cond and yes = exp t yes and no = exp t no in
+    fun () ->
+      let c = cond () in
+      if is_true c then yes ()
+      else if is_false c then no ()
+      else Bot
+  | Exp.Extract (hi,lo,x) ->
+    let x = exp t x in
+    fun () -> begin match x () with
+      | Imm w ->
+        begin
+          try Imm (Bitvector.extract_exn ~hi ~lo w)
+          with exn -> Bot
+        end
+      | _ -> Bot
+    end
+  | Exp.Concat (x,y) ->
+    let x = exp t x and y = exp t y in
+    fun () -> concat (x ()) (y ())
+
+let nop () = ()
+
+let rec stmt t s : unit -> unit = match s with
+  | Stmt.Move (v,x) ->
+    let i = slot t v and x = exp t x in
+    fun () -> t.regs.(i) <- x ()
+  | Stmt.Jmp x ->
+    let x = exp t x in
+    fun () -> begin match x () with
+      | Mem _ -> ()
+      | dst -> t.pc <- dst
+    end
+  | Stmt.Special _ | Stmt.CpuExn _ -> nop
+  | Stmt.While (cond,body) ->
+    let cond = exp t cond and body = stmts t body in
+    let rec loop () = if is_true (cond ()) then (body (); loop ()) in
+    loop
+  | Stmt.If (cond,yes,no) ->
+    let cond = exp t cond and yes = stmts t yes and no = stmts t no in
+    fun () ->
+      let c = cond () in
+      if is_true c then yes ()
+      else if is_false c then no ()
+and stmts t ss = match List.map ss ~f:(stmt t) with
+  | [] -> nop
+  | [s] -> s
+  | ss ->
+    let ss = Array.of_list ss in
+    fun () -> Array.iter ss ~f:(fun s -> s ())
+
+let compile = stmts
+let compile_exp = exp
+let run program = program ()
+let eval ss t = run (compile t ss)
@@ -0,0 +1,18 @@
+open Core_kernel.Std
+open Bap_common
+open Bap_bil
+open Bap_result
+
+type t
+type program
+
+val create : unit -> t
+val compile : t -> stmt list -> program
+val compile_exp : t -> exp -> (unit -> value)
+val run : program -> unit
+val eval : stmt list -> t -> unit
+val lookup : t -> var -> value
+val update : t -> var -> value -> unit
+val pc : t -> value
+val with_pc : t -> value -> unit
+val bindings : t -> (var * value) Sequence.t
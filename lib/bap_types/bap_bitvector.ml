@@ -50,6 +50,9 @@ module type Kernel = sig
   val with_z : t -> bignum -> t
   val lift1 : (bignum -> bignum) -> t -> t
   val lift2 : (bignum -> bignum -> bignum) -> t -> t -> t
+  val lift1i : (int -> int) -> (bignum -> bignum) -> t -> t
+  val lift2i : (int -> int -> int) ->
+    (bignum -> bignum -> bignum) -> t -> t -> t
   val unop  : (bignum -> 'a) -> t -> 'a
   val binop : (bignum -> bignum -> 'a) -> t -> t -> 'a
   val extract : ?hi:int -> ?lo:int -> t -> t Or_error.t
@@ -73,7 +76,24 @@ module Make(Size : Compare) : Kernel = struct
   let version = "0.1"
 
 
-  let znorm z w = Bignum.(z land ((one lsl w) - one))
+  (* Zarith keeps numbers that fit into an OCaml int unboxed, so
+     bitvectors of up to [small] bits never allocate a number, if they
+     are normalized with a native mask, and computed with native
+     operations. Masks of larger common widths are precomputed. *)
+  let small = Sys.word_size - 2
+
+  let int_mask w = (1 lsl w) - 1
+
+  let masks = Array.init 257 ~f:(fun w -> Bignum.((one lsl w) - one))
+
+  let mask w =
+    if w < Array.length masks then masks.(w)
+    else Bignum.((one lsl w) - one)
+
+  let znorm z w =
+    if w <= small && Bignum.fits_int z
+    then Bignum.of_int (Bignum.to_int z land int_mask w)
+    else Bignum.(z land mask w)
 
   (** Extend that sign bit.
     * This makes Zarith treat the normalized input as if it were signed. *)
@@ -103,6 +123,25 @@ module Make(Size : Compare) : Kernel = struct
   let lift1 op t = with_z t (unop op t)
   let lift2 op t1 t2 = create (binop op t1 t2) t1.w
 
+  (* [lift1i iop op] and [lift2i iop op] apply a native operation
+     [iop] to small bitvectors, and [op] to all others. Only
+     operations that compute the low bits of the result independently
+     of the higher bits, e.g., addition, multiplication, and bitwise
+     operations, may be lifted this way, as the sign of operands is
+     ignored, and the result is truncated. *)
+  let lift1i iop op t =
+    if t.w <= small
+    then {t with z = Bignum.of_int (iop (Bignum.to_int t.z) land int_mask t.w)}
+    else lift1 op t
+
+  let lift2i iop op t1 t2 =
+    if t1.w <= small && t2.w <= small then {
+      z = Bignum.of_int (iop (Bignum.to_int t1.z) (Bignum.to_int t2.z)
+                         land int_mask t1.w);
+      w = t1.w;
+      signed = false;
+    } else lift2 op t1 t2
+
   let compare l r =
     let s = Size.compare l.w r.w in
     if s <> 0 then s else
@@ -194,8 +233,8 @@ let of_binary ?width endian num  =
 
 
 
-let nsucc t n = with_z t Bignum.(z t + of_int n)
-let npred t n = with_z t Bignum.(z t - of_int n)
+let nsucc t n = lift1i (fun x -> x + n) (fun z -> Bignum.(z + of_int n)) t
+let npred t n = lift1i (fun x -> x - n) (fun z -> Bignum.(z - of_int n)) t
 
 let (++) t n = nsucc t n
 let (--) t n = npred t n
@@ -228,10 +267,17 @@ module Safe = struct
 
   let lift1 op x : m = x >>| lift1 op
 
-  let lift2 op (x : m) (y : m) : m =
-    x >>= fun x -> y >>= fun y ->
-    let v = validate_equal (bitwidth x, bitwidth y) in
-    Validate.result v >>| fun () -> lift2 op x y
+  let lift1i iop op x : m = x >>| lift1i iop op
+
+  let lift2_with lift (x : m) (y : m) : m = match x, y with
+    | Ok x, Ok y when bitwidth x = bitwidth y -> Ok (lift x y)
+    | _ ->
+      x >>= fun x -> y >>= fun y ->
+      let v = validate_equal (bitwidth x, bitwidth y) in
+      Validate.result v >>| fun () -> lift x y
+
+  let lift2 op = lift2_with (lift2 op)
+  let lift2i iop op = lift2_with (lift2i iop op)
 
 
 
@@ -251,19 +297,19 @@ module Safe = struct
     type t = m
     let one = i1 (one 1)
     let zero = i1 (zero 1)
-    let succ = lift1 Bignum.succ
-    let pred = lift1 Bignum.pred
+    let succ = lift1i Int.succ Bignum.succ
+    let pred = lift1i Int.pred Bignum.pred
     let abs  = lift1 Bignum.abs
-    let neg  = lift1 Bignum.neg
+    let neg  = lift1i Int.neg Bignum.neg
 
-    let lnot = lift1 Bignum.lognot
+    let lnot = lift1i Int.bit_not Bignum.lognot
 
-    let logand = lift2 Bignum.logand
-    let logor  = lift2 Bignum.logor
-    let logxor = lift2 Bignum.logxor
-    let add    = lift2 Bignum.add
-    let sub    = lift2 Bignum.sub
-    let mul    = lift2 Bignum.mul
+    let logand = lift2i Int.bit_and Bignum.logand
+    let logor  = lift2i Int.bit_or  Bignum.logor
+    let logxor = lift2i Int.bit_xor Bignum.logxor
+    let add    = lift2i Int.(+) Bignum.add
+    let sub    = lift2i Int.(-) Bignum.sub
+    let mul    = lift2i Int.( * ) Bignum.mul
     let sdiv   = lift2 Bignum.div
     let udiv   = lift2 Bignum.ediv
     let srem   = lift2 Bignum.rem
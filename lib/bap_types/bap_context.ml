@@ -11,3 +11,88 @@ class t = object
   method update key data = {< delta = Map.add delta ~key ~data >}
   method bindings = Map.to_sequence delta
 end
+
+(* [reserve regs n] is [regs] if it has the slot [n], or a larger
+   copy of it otherwise *)
+let reserve regs n =
+  let len = Array.length regs in
+  if n < len then regs
+  else
+    let regs' = Array.create ~len:(Int.max 16 (2 * n)) None in
+    Array.blit ~src:regs ~src_pos:0 ~dst:regs' ~dst_pos:0 ~len;
+    regs'
+
+(* Variables are mapped to dense slots, in the order in which they
+   are first bound, so that the registers of a context are sized by
+   the number of variables in it, not by the number of variables in
+   the process. The table only grows, and a slot is never reassigned,
+   so it is shared by a context and all its copies, and is never
+   copied. The table references its variables, so that their
+   identifiers are not reused by other variables. *)
+type slots = {
+  mutable index : int array;    (* variable id -> slot + 1 *)
+  mutable keys : Bap_var.t array; (* slot -> variable *)
+  mutable size : int;
+}
+
+let new_slots () = {index = [||]; keys = [||]; size = 0}
+
+let find_slot slots var =
+  let n = Bap_var.id var in
+  if n < Array.length slots.index then slots.index.(n) - 1 else -1
+
+let slot slots var = match find_slot slots var with
+  | -1 ->
+    let n = Bap_var.id var in
+    let len = Array.length slots.index in
+    if n >= len then begin
+      let index = Array.create ~len:(Int.max 64 (2 * n)) 0 in
+      Array.blit ~src:slots.index ~src_pos:0 ~dst:index ~dst_pos:0 ~len;
+      slots.index <- index
+    end;
+    if slots.size = Array.length slots.keys then begin
+      let keys = Array.create ~len:(Int.max 16 (2 * slots.size)) var in
+      Array.blit ~src:slots.keys ~src_pos:0 ~dst:keys ~dst_pos:0
+        ~len:slots.size;
+      slots.keys <- keys
+    end;
+    slots.keys.(slots.size) <- var;
+    slots.size <- slots.size + 1;
+    slots.index.(n) <- slots.size;
+    slots.size - 1
+  | n -> n
+
+class flat = object(self)
+  val slots = new_slots ()
+  val mutable regs : result option array = [||]
+  val born = current_epoch ()
+
+  method lookup var =
+    let n = find_slot slots var in
+    if n >= 0 && n < Array.length regs then regs.(n) else None
+
+  method update var data =
+    let n = slot slots var in
+    if born = current_epoch () then begin
+      regs <- reserve regs n;
+      regs.(n) <- Some data;
+      self
+    end else begin
+      let regs = reserve (Array.copy regs) n in
+      regs.(n) <- Some data;
+      {< regs = regs; born = current_epoch () >}
+    end
+
+  method bindings =
+    let regs = Array.copy regs in
+    let index = Array.copy slots.index and keys = slots.keys in
+    Sequence.range 0 (Array.length index) |>
+    Sequence.filter_map ~f:(fun id ->
+        let n = index.(id) - 1 in
+        if n < 0 || n >= Array.length regs then None
+        else Option.map regs.(n) ~f:(fun r -> keys.(n), r))
+
+  method copy = {< regs = Array.copy regs >}
+end
+
+let snapshot = Bap_result.snapshot
@@ -8,3 +8,10 @@ class t : object('s)
   method update : var -> result -> 's
   method bindings : (var * result) Sequence.t
 end
+
+class flat : object('s)
+  inherit t
+  method copy : 's
+end
+
+val snapshot : unit -> unit
@@ -49,6 +49,13 @@ let word s id = {id; v = Imm s}
 let value s = s.v
 let id s = s.id
 
+(* Mutable states are modified in place only in the epoch, in which
+   they were created. After the epoch is changed, they are copied on a
+   first update, so that a state, captured before, is not affected. *)
+let epoch = ref 0
+let snapshot () = incr epoch
+let current_epoch () = !epoch
+
 module Storage = struct
   class linear : storage = object
     val storage = []
@@ -61,6 +68,145 @@ module Storage = struct
     method save x u = {< storage = Map.add storage ~key:x ~data:u >}
     method load x = Map.find storage x
   end
+
+  (* Bytes are stored in 4 KiB pages, with a bitmap of written bytes.
+     A page can be modified only by its owner, any other storage
+     copies the page on the first write. A copy of a storage shares
+     all pages with the original, and both get new owner identifiers,
+     so the pages become read-only for both of them.
+
+     As in other storages, addresses of different widths are
+     different, even if their values are equal. Pages hold addresses
+     of one width, the width of the first stored byte. Words, that
+     are not bytes, as well as words at addresses of other widths or
+     at addresses that do not fit into an integer, are kept in a map,
+     keyed by the address with its width. *)
+  type page = {
+    owner : int;
+    data : Bigstring.t;
+    known : Bytes.t;
+  }
+
+  let page_bits = 12
+  let page_size = 1 lsl page_bits
+
+  let new_owner =
+    let last = ref 0 in
+    fun () -> incr last; !last
+
+  let new_page owner = {
+    owner;
+    data = Bigstring.create page_size;
+    known = Bytes.make (page_size / 8) '\000';
+  }
+
+  let copy_page owner p = {
+    owner;
+    data = Bigstring.sub p.data;
+    known = Bytes.copy p.known;
+  }
+
+  let is_known p off =
+    Char.to_int (Bytes.get p.known (off lsr 3)) land (1 lsl (off land 7)) <> 0
+
+  let set_known p off known =
+    let b = Char.to_int (Bytes.get p.known (off lsr 3)) in
+    let m = 1 lsl (off land 7) in
+    let b = if known then b lor m else b land lnot m in
+    Bytes.set p.known (off lsr 3) (Char.of_int_exn b)
+
+  let bytes = Array.init 256 ~f:(Bitvector.of_int ~width:8)
+
+  (* A mutable part of the storage. A state is modified in place only
+     in the epoch, in which it was created, afterwards it is copied
+     on a first write. *)
+  type state = {
+    mutable owner : int;
+    born : int;
+    mutable width : int option;
+    pages : page Int.Table.t;
+    mutable words : word Bitvector.Map.t;
+  }
+
+  let new_state () = {
+    owner = new_owner ();
+    born = !epoch;
+    width = None;
+    pages = Int.Table.create ();
+    words = Bitvector.Map.empty;
+  }
+
+  let copy_state s = {
+    owner = new_owner ();
+    born = !epoch;
+    width = s.width;
+    pages = Hashtbl.copy s.pages;
+    words = s.words;
+  }
+
+  let locate s addr =
+    let width = Bitvector.bitwidth addr in
+    if Option.exists s.width ~f:(fun w -> w <> width) then None
+    else match Bitvector.to_int addr with
+      | Ok a when a >= 0 -> Some (a lsr page_bits, a land (page_size - 1))
+      | _ -> None
+
+  let writable s n = match Hashtbl.find s.pages n with
+    | Some p when p.owner = s.owner -> p
+    | Some p ->
+      let p = copy_page s.owner p in
+      Hashtbl.set s.pages ~key:n ~data:p;
+      p
+    | None ->
+      let p = new_page s.owner in
+      Hashtbl.set s.pages ~key:n ~data:p;
+      p
+
+  let load s x =
+    let page = match locate s x with
+      | None -> None
+      | Some (n,off) -> match Hashtbl.find s.pages n with
+        | Some p when is_known p off ->
+          Some bytes.(Char.to_int (Bigstring.get p.data off))
+        | _ -> None in
+    match page with
+    | None when not (Map.is_empty s.words) -> Map.find s.words x
+    | r -> r
+
+  let save s x u = match locate s x with
+    | None -> s.words <- Map.add s.words ~key:x ~data:u
+    | Some (n,off) when Bitvector.bitwidth u = 8 ->
+      if Option.is_none s.width
+      then s.width <- Some (Bitvector.bitwidth x);
+      let p = writable s n in
+      let u = Bitvector.to_int u |> ok_exn in
+      Bigstring.set p.data off (Char.of_int_exn u);
+      set_known p off true;
+      if not (Map.is_empty s.words) then s.words <- Map.remove s.words x
+    | Some (n,off) ->
+      if Hashtbl.mem s.pages n then set_known (writable s n) off false;
+      s.words <- Map.add s.words ~key:x ~data:u
+
+  class paged : object('s)
+    inherit storage
+    method copy : 's
+  end = object(self)
+    val s = new_state ()
+
+    method load x = load s x
+
+    method save x u =
+      if s.born = !epoch then (save s x u; self)
+      else
+        let s = copy_state s in
+        save s x u;
+        {< s = s >}
+
+    method copy =
+      let copy = {< s = copy_state s >} in
+      s.owner <- new_owner ();
+      copy
+  end
 end
 
 module Value = struct
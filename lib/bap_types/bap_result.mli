@@ -31,9 +31,20 @@ val value : t -> value
 
 module Value : Printable with type t = value
 
+(** [snapshot ()] starts a new epoch of mutable states  *)
+val snapshot : unit -> unit
+
+(** [current_epoch ()] is the epoch, started by the last
+    [snapshot ()]  *)
+val current_epoch : unit -> int
+
 module Storage : sig
   class linear : storage
   class sparse : storage
+  class paged : object('s)
+    inherit storage
+    method copy : 's
+  end
 end
 
 module Id : sig
@@ -93,6 +93,7 @@ module Std = struct
 
   module Expi = Bap_expi
   module Bili = Bap_bili
+  module Bilc = Bap_bilc
   module Biri = Bap_biri
   module Type_error = Bap_type_error
   module Context = Bap_context
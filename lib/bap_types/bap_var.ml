@@ -13,15 +13,125 @@ module Id = struct
     !id
 end
 
-module T = struct
+(* a variable without its identifier  *)
+module Repr = struct
   type t = {
     var : string;
     ind : int;
     typ : typ;
     vir : bool;
   } [@@deriving sexp, bin_io, compare]
+end
+
+(* Variables are interned. Each distinct variable is created only
+   once, and is assigned a dense identifier, so that two variables
+   are equal iff their identifiers are equal. The identifiers are
+   local to a process. The table is weak, so a variable, that is no
+   longer used, e.g., a temporary of a lifter, is collected, and its
+   identifier is reused.
+
+   A variable is either interned in a table, or is an alias to an
+   interned variable, that is kept alive by the alias. The table is
+   identified by a block, that is physically equal to [table] only
+   in the process, that created the variable, so a variable, that
+   was read with Marshal, e.g., from a project cache, is detected,
+   and on the first use of its identifier it is either interned, or
+   becomes an alias. *)
+type t = {
+  mutable id  : int;
+  var : string;
+  ind : int;
+  typ : typ;
+  vir : bool;
+  mutable home : home;
+}
+and home = Table of unit ref | Alias of t
+
+let table = ref ()
+
+module Interned = Caml.Weak.Make(struct
+    type nonrec t = t
+    let equal x y =
+      String.equal x.var y.var && Int.equal x.ind y.ind &&
+      Bool.equal x.vir y.vir && compare_typ x.typ y.typ = 0
+    let hash v = Hashtbl.hash (v.var, v.ind, v.typ, v.vir)
+  end)
+
+let interned = Interned.create 1024
+
+(* interned variables, indexed by their identifiers *)
+let vars = ref (Caml.Weak.create 1024)
+let next = ref 0
+let free = ref []
+
+(* identifiers of collected variables are reclaimed, when the table
+   is full, and the table is doubled, if less than a half of it was
+   reclaimed, so that a sweep is amortized by allocations *)
+let reclaim () =
+  let len = Caml.Weak.length !vars in
+  for id = len - 1 downto 0 do
+    if not (Caml.Weak.check !vars id) then free := id :: !free
+  done;
+  if List.length !free < len / 2 then begin
+    let vars' = Caml.Weak.create (2 * len) in
+    Caml.Weak.blit !vars 0 vars' 0 len;
+    vars := vars'
+  end
+
+let rec fresh_id () = match !free with
+  | id :: ids -> free := ids; id
+  | [] when !next < Caml.Weak.length !vars -> incr next; !next - 1
+  | [] -> reclaim (); fresh_id ()
+
+let add v =
+  v.id <- fresh_id ();
+  v.home <- Table table;
+  Caml.Weak.set !vars v.id (Some v)
+
+let repr {var; ind; typ; vir; _} = {Repr.var; ind; typ; vir}
+
+let intern {Repr.var; ind; typ; vir} =
+  let v = {id = -1; var; ind; typ; vir; home = Table table} in
+  let v' = Interned.merge interned v in
+  if phys_equal v v' then add v;
+  v'
 
-  let hash v = String.hash v.var
+let rec is_local v = match v.home with
+  | Table t -> phys_equal t table
+  | Alias v -> is_local v
+
+(* [v] is rewritten in place, so it is interned only once *)
+let rehome v =
+  let v' = Interned.merge interned v in
+  if phys_equal v v' then add v
+  else begin
+    v.id <- v'.id;
+    v.home <- Alias v'
+  end
+
+let id v =
+  if not (is_local v) then rehome v;
+  v.id
+
+let of_id id = match Caml.Weak.get !vars id with
+  | Some v -> v
+  | None -> invalid_argf "Var.of_id: no variable with id %d" id ()
+
+module T = struct
+  type nonrec t = t
+  include Sexpable.Of_sexpable(Repr)(struct
+      type nonrec t = t
+      let to_sexpable = repr
+      let of_sexpable = intern
+    end)
+  include Binable.Of_binable(Repr)(struct
+      type nonrec t = t
+      let to_binable = repr
+      let of_binable = intern
+    end)
+
+  let compare x y = Int.compare (id x) (id y)
+  let hash = id
   let module_name = Some "Bap.Std.Var"
   let version = "0.1"
   let pp fmt v =
@@ -32,9 +142,10 @@ end
 include T
 
 let name v = v.var
-let with_index v ind = {v with ind}
+let with_index v ind =
+  if v.ind = ind then v else intern {(repr v) with Repr.ind}
 let index v = v.ind
-let base v = {v with ind = 0}
+let base v = with_index v 0
 let typ  v = v.typ
 let is_physical v = not v.vir
 let is_virtual v = v.vir
@@ -44,8 +155,157 @@ let create ?(is_virtual=false) ?(fresh=false) name typ =
   let var =
     if fresh then name ^ Int63.to_string (Id.create ())
     else name in
-  {ind = 0; var; typ; vir = is_virtual}
+  intern {Repr.ind = 0; var; typ; vir = is_virtual}
 
-let same x y = base x = base y
+let same x y = Int.equal (id (base x)) (id (base y))
 
 include Regular.Make(T)
+
+(* variables, that are never collected, indexed by identifiers *)
+let pinned : t array ref = ref [||]
+
+let pin v =
+  let n = id v in
+  let len = Array.length !pinned in
+  if n >= len then begin
+    let pinned' = Array.create ~len:(Int.max 1024 (2 * n)) v in
+    Array.blit ~src:!pinned ~src_pos:0 ~dst:pinned' ~dst_pos:0 ~len;
+    pinned := pinned'
+  end;
+  !pinned.(n) <- v
+
+(* sets are bit vectors, indexed by variable identifiers. Only the
+   words between the first and the last non-zero word are kept, so
+   that the size of a set doesn't depend on the smallest identifier
+   in it, and equal sets are structurally equal. A set doesn't
+   reference its members, so they are pinned, when added, otherwise
+   an identifier in a set may be reused by another variable. *)
+module Bitset = struct
+  type var = t
+  type t = {
+    base : int;                 (* the index of the first word *)
+    words : int array;
+  }
+
+  let bits = Sys.word_size - 1
+
+  let word v = id v / bits
+  let bit v = 1 lsl (id v mod bits)
+
+  let empty = {base = 0; words = [||]}
+  let is_empty s = Array.length s.words = 0
+
+  let get s w =
+    let i = w - s.base in
+    if i >= 0 && i < Array.length s.words then s.words.(i) else 0
+
+  (* a set of words [w] in [lo,hi) with values [f w] *)
+  let init lo hi ~f =
+    let rec first w = if w < hi && f w = 0 then first (w+1) else w in
+    let lo = first lo in
+    let rec last w = if w > lo && f (w-1) = 0 then last (w-1) else w in
+    let hi = last hi in
+    if lo >= hi then empty
+    else {base = lo; words = Array.init (hi - lo) ~f:(fun i -> f (lo + i))}
+
+  let lower s = s.base
+  let upper s = s.base + Array.length s.words
+
+  let mem s v = get s (word v) land bit v <> 0
+
+  let singleton v = pin v; {base = word v; words = [|bit v|]}
+
+  let union x y =
+    if is_empty x then y else
+    if is_empty y then x else
+      init (Int.min (lower x) (lower y)) (Int.max (upper x) (upper y))
+        ~f:(fun w -> get x w lor get y w)
+
+  let inter x y =
+    init (Int.max (lower x) (lower y)) (Int.min (upper x) (upper y))
+      ~f:(fun w -> get x w land get y w)
+
+  let diff x y =
+    if is_empty y then x
+    else init (lower x) (upper x) ~f:(fun w -> get x w land lnot (get y w))
+
+  let add s v = if mem s v then s else union s (singleton v)
+  let remove s v = if mem s v then diff s (singleton v) else s
+
+  let equal x y = x.base = y.base && x.words = y.words
+  let subset x y = is_empty (diff x y)
+
+  let fold s ~init ~f =
+    let acc = ref init in
+    Array.iteri s.words ~f:(fun i w ->
+        if w <> 0 then
+          for j = 0 to bits - 1 do
+            if w land (1 lsl j) <> 0
+            then acc := f !acc (of_id ((s.base + i) * bits + j))
+          done);
+    !acc
+
+  let iter s ~f = fold s ~init:() ~f:(fun () v -> f v)
+  let length s = fold s ~init:0 ~f:(fun n _ -> n + 1)
+  let elements s = List.rev (fold s ~init:[] ~f:(fun vs v -> v :: vs))
+
+  (* builds a set of variables, enumerated by [iter], into one array,
+     that spans the words of the variables *)
+  let build iter vs =
+    let lo = ref Int.max_value and hi = ref Int.min_value in
+    iter vs ~f:(fun v ->
+        lo := Int.min !lo (word v);
+        hi := Int.max !hi (word v));
+    if !lo > !hi then empty
+    else
+      let words = Array.create ~len:(!hi - !lo + 1) 0 in
+      iter vs ~f:(fun v ->
+          pin v;
+          let i = word v - !lo in
+          words.(i) <- words.(i) lor bit v);
+      {base = !lo; words}
+
+  let of_list vs = build List.iter vs
+  let to_set s = fold s ~init:Set.empty ~f:Set.add
+  let of_set vs = build Set.iter vs
+end
+
+(* maps are arrays, indexed by variable identifiers, a key is stored
+   with its data, so that it is not collected, while it is bound *)
+module Array_map = struct
+  type var = t
+  type 'a t = {mutable data : (var * 'a) option array}
+
+  let create () = {data = [||]}
+  let copy t = {data = Array.copy t.data}
+
+  let find t v =
+    let n = id v in
+    if n < Array.length t.data then Option.map t.data.(n) ~f:snd
+    else None
+
+  let mem t v = Option.is_some (find t v)
+
+  let set t ~key ~data =
+    let n = id key in
+    let len = Array.length t.data in
+    if n >= len then begin
+      let data' = Array.create ~len:(Int.max 64 (2 * n)) None in
+      Array.blit ~src:t.data ~src_pos:0 ~dst:data' ~dst_pos:0 ~len;
+      t.data <- data'
+    end;
+    t.data.(n) <- Some (key,data)
+
+  let remove t v =
+    let n = id v in
+    if n < Array.length t.data then t.data.(n) <- None
+
+  let iteri t ~f = Array.iter t.data ~f:(function
+      | None -> ()
+      | Some (key,data) -> f ~key ~data)
+
+  let fold t ~init ~f =
+    let acc = ref init in
+    iteri t ~f:(fun ~key ~data -> acc := f ~key ~data !acc);
+    !acc
+end
@@ -13,3 +13,41 @@ val typ : t -> typ
 val is_virtual : t -> bool
 val is_physical : t -> bool
 module Id : Bap_state.S
+val id : t -> int
+val of_id : int -> t
+
+module Bitset : sig
+  type var = t
+  type t
+  val empty : t
+  val singleton : var -> t
+  val is_empty : t -> bool
+  val mem : t -> var -> bool
+  val add : t -> var -> t
+  val remove : t -> var -> t
+  val union : t -> t -> t
+  val inter : t -> t -> t
+  val diff : t -> t -> t
+  val equal : t -> t -> bool
+  val subset : t -> t -> bool
+  val length : t -> int
+  val fold : t -> init:'a -> f:('a -> var -> 'a) -> 'a
+  val iter : t -> f:(var -> unit) -> unit
+  val elements : t -> var list
+  val of_list : var list -> t
+  val to_set : t -> Set.t
+  val of_set : Set.t -> t
+end
+
+module Array_map : sig
+  type var = t
+  type 'a t
+  val create : unit -> 'a t
+  val copy : 'a t -> 'a t
+  val find : 'a t -> var -> 'a option
+  val mem : 'a t -> var -> bool
+  val set : 'a t -> key:var -> data:'a -> unit
+  val remove : 'a t -> var -> unit
+  val iteri : 'a t -> f:(key:var -> data:'a -> unit) -> unit
+  val fold : 'a t -> init:'b -> f:(key:var -> data:'a -> 'b -> 'b) -> 'b
+end
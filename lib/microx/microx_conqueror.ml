@@ -59,12 +59,14 @@ class context
           let old = old#merge self in
           Some (old#set_next (Some p))
 
+  (* the checkpoint must not be affected by the further updates of a
+     mutable state, if one is used. *)
   method add_checkpoint p = match List.hd callstack with
     | None -> self
     | Some sub ->
       let key = Term.tid sub in
       if Map.mem vis p then self
-      else {<
+      else let () = Context.snapshot () in {<
         cps = Map.update cps key ~f:(function
             | None -> Tid.Map.singleton p self
             | Some ps -> Map.add ps p self)
@@ -113,11 +115,24 @@ class context
     | _ -> false
 end
 
-class ['a] main ?(deterministic=false) p =
+(* Registers are kept in a flat array, and checkpoints are
+   snapshots, so a path is explored without persistent updates, and
+   backtracking to a checkpoint doesn't copy anything, that was not
+   modified since then. *)
+class forkable ?max_steps ?max_loop p = object
+  inherit context ?max_steps ?max_loop p
+  inherit! Context.flat
+end
+
+class ['a] main ?(deterministic=false) ?(paged=false) p =
   object(self)
     constraint 'a = #context
     inherit ['a] Biri.t as super
 
+    method! empty =
+      if paged then (new Bil.Storage.paged :> Bil.storage)
+      else super#empty
+
     method! enter_term cls t =
       let tid = Term.tid t in
       SM.update (fun ctxt -> ctxt#visit_term tid) >>= fun () ->
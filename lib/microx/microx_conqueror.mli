@@ -27,7 +27,20 @@ class context :
     method will_return : tid -> bool
   end
 
-class ['a] main : ?deterministic:bool -> program term -> object
+(** a context, that keeps registers in a mutable flat array, and
+    takes a snapshot of the whole state at each checkpoint. Use it
+    with [main ~paged:true] to keep memory in copy-on-write pages. *)
+class forkable :
+  ?max_steps:int ->
+  ?max_loop:int ->
+  program term -> object('s)
+    inherit context
+    method copy : 's
+  end
+
+(** if [paged] is [true] (defaults to [false]), then memory is kept
+    in a mutable paged storage.  *)
+class ['a] main : ?deterministic:bool -> ?paged:bool -> program term -> object
     inherit ['a] biri
     constraint 'a = #context
   end
@@ -8,6 +8,7 @@ let suite () =
     Test_trie.suite ();
     Test_bitvector.suite ();
     Test_bili.suite ();
+    Test_var.suite ();
     Test_graph.suite ();
     Test_image.suite ();
     Test_table.suite ();
@@ -6,6 +6,7 @@ open OUnit2
 
 module Dis = Disasm_expert.Basic
 module Rec = Disasm_expert.Recursive
+module Linear = Disasm_expert.Linear
 module Cfg = Graphs.Cfg
 
 let err fmt = Or_error.errorf fmt
@@ -358,6 +359,119 @@ let call1_3ret ctxt =
     Seq.is_empty (Cfg.Node.succs b3 cfg);
   | _ -> assert false
 
+(* explores strlen from the entry and from the last block, so that
+   each of two workers gets its own root. *)
+let parallel ctxt =
+  let mem = create_block 0x840Cl strlen in
+  let rooter = Rooter.create @@ Seq.of_list [
+      Memory.min_addr blocks.(0);
+      Memory.min_addr blocks.(3);
+    ] in
+  let run jobs = Rec.run ~rooter ~jobs `armv7 mem |> Or_error.ok_exn in
+  let sort x = List.sort ~cmp:Polymorphic_compare.compare x in
+  let deepsort graph =
+    List.map graph ~f:(fun (id,preds,succs) ->
+        id, sort preds, sort succs) |> sort in
+  let printer g = Sexp.to_string (sexp_of_graph g) in
+  let seq = run 1 and par = run 2 in
+  assert_bool "No errors" (Rec.errors par = []);
+  assert_equal ~ctxt ~printer ~msg:"Parallel and sequential differ"
+    (deepsort (build_graph seq)) (deepsort (build_graph par))
+
+(* instructions, that are found by the x86 length decoder, with
+   their expected lengths. A truncated instruction ends the sweep. *)
+let x86_lengths : (arch * string * int list) list = [
+  (* prefixes *)
+  `x86_64, "\x66\x90", [2];
+  `x86_64, "\xf3\x48\xa5", [3];
+  `x86_64, "\x66\xb8\x01\x00", [4];
+  `x86_64, String.make 16 '\x66' ^ "\x90", [1; 1; 15];
+  (* REX *)
+  `x86_64, sub, [4];
+  `x86_64, "\x48\xb8\x01\x02\x03\x04\x05\x06\x07\x08", [10];
+  `x86_64, "\xb8\x01\x02\x03\x04", [5];
+  (* VEX, EVEX and XOP *)
+  `x86_64, "\xc5\xf8\x77", [3];
+  `x86_64, "\xc5\xf9\x6f\xc1", [4];
+  `x86_64, "\xc4\xe3\x79\x0f\xc1\x08", [6];
+  `x86_64, "\x62\xf1\x7c\x48\x28\xc1", [6];
+  `x86_64, "\x8f\xe9\x78\xe1\xc1", [5];
+  (* ModRM, SIB and displacements *)
+  `x86_64, "\x8b\x04\x24", [3];
+  `x86_64, "\x8b\x04\x25\x00\x00\x00\x00", [7];
+  `x86_64, "\x8b\x05\x00\x00\x00\x00", [6];
+  `x86_64, "\x8b\x44\x24\x08", [4];
+  `x86_64, "\x8b\x80\x00\x00\x00\x00", [6];
+  `x86_64, lea, [3];
+  `x86_64, "\xf6\xc0\x01", [3];
+  `x86_64, "\xf6\xd0", [2];
+  `x86_64, "\x0f\x38\x00\xc1", [4];
+  `x86_64, "\x0f\x3a\x0f\xc1\x08", [5];
+  (* 3DNow! *)
+  `x86_64, "\x0f\x0f\xc1\xb4", [4];
+  `x86, "\x0f\x0f\xc1\xb4", [4];
+  (* operand and address sizes *)
+  `x86_64, call, [5];
+  `x86_64, "\x66\xe8\x00\x00\x00\x00", [6];
+  `x86, "\x66\xe8\x00\x00", [4];
+  `x86_64, "\xa1\x01\x02\x03\x04\x05\x06\x07\x08", [9];
+  `x86, "\xa1\x01\x02\x03\x04", [5];
+  `x86, "\x67\x8b\x46\x08", [4];
+  (* 32- vs 64-bit mode *)
+  `x86, sub, [1; 3];
+  `x86, "\xc4\x00", [2];
+  `x86, "\x06", [1];
+  `x86_64, "\x06", [1];
+  `x86, "\x9a\x01\x02\x03\x04\x05\x06", [7];
+  (* truncated input *)
+  `x86_64, "\x48\xb8\x00", [];
+  `x86_64, "\x62\xf1\x7c\x48", [];
+  `x86, "\x90\xe8\x00", [1];
+]
+
+let lengths mems = List.map mems ~f:Memory.length
+
+let length_decoder ctxt =
+  let printer = List.to_string ~f:Int.to_string in
+  List.iter x86_lengths ~f:(fun (arch,data,expect) ->
+      let width = Size.in_bits (Arch.addr_size arch) in
+      let mem = memory_of_string ~width data in
+      let msg = sprintf "%s: %S" (Arch.to_string arch) data in
+      assert_equal ~ctxt ~printer ~msg expect
+        (lengths (Linear.With_exn.boundaries arch mem)))
+
+(* the length decoder and the disassembler agree on boundaries, and
+   every found instruction is decoded *)
+let boundaries (arch,insns) ctxt =
+  let printer = List.to_string ~f:Int.to_string in
+  let width = Size.in_bits (Arch.addr_size arch) in
+  let mem = memory_of_string ~width (String.concat insns) in
+  let expect =
+    Dis.with_disasm ~backend:"llvm" (Arch.to_string arch) ~f:(fun dis ->
+        Dis.run dis mem ~init:[] ~return:ident ~stopped:(fun s _ ->
+            Dis.stop s (Dis.insns s)) |>
+        List.map ~f:fst |> Or_error.return) |> Or_error.ok_exn in
+  assert_equal ~ctxt ~printer (List.map insns ~f:String.length)
+    (lengths expect);
+  let found = Linear.With_exn.boundaries arch mem in
+  assert_equal ~ctxt ~printer (lengths expect) (lengths found);
+  Linear.With_exn.decode arch found |> List.iter ~f:(function
+      | mem, None -> assert_string ("not decoded: " ^ Memory.to_string mem)
+      | _, Some _ -> ())
+
+let boundaries_x86_64 : arch * string list = `x86_64, [
+    sub; call; mov; add; leaq; lea; "\x66\x90";
+    "\x8b\x04\x24"; "\x8b\x44\x24\x08";
+    "\x48\xb8\x01\x02\x03\x04\x05\x06\x07\x08";
+    "\xc5\xf9\x6f\xc1"; "\xc4\xe3\x79\x0f\xc1\x08";
+    "\x0f\x38\x00\xc1"; ret;
+  ]
+
+let boundaries_x86 : arch * string list = `x86, [
+    "\x55"; "\x89\xe5"; "\x83\xec\x08"; "\x8b\x45\x08";
+    "\xa1\x00\x00\x00\x00"; "\x8d\x04\x40"; "\x48"; "\xc9"; ret;
+  ]
+
 let suite () = "Disasm.Basic" >::: [
     "x86_64/one"            >:: test_insn_of_mem x86_64;
     "x86_64/all"            >:: test_run_all     x86_64;
@@ -367,4 +481,8 @@ let suite () = "Disasm.Basic" >::: [
     "ret"                   >:: test_micro_cfg ret;
     "sub"                   >:: test_micro_cfg sub;
     "call1_3ret"            >:: call1_3ret;
+    "parallel"              >:: parallel;
+    "x86 length decoder"    >:: length_decoder;
+    "x86_64/boundaries"     >:: boundaries boundaries_x86_64;
+    "x86/boundaries"        >:: boundaries boundaries_x86;
   ]
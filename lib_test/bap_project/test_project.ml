@@ -87,7 +87,76 @@ let test_substitute case : test list =
 
 
 
+(* a relocatable x86-64 ELF object with a single .text section *)
+let elf_object code =
+  let b = Buffer.create 512 in
+  let le w n = for i = 0 to w - 1 do
+      Buffer.add_char b (Char.of_int_exn ((n lsr (8 * i)) land 0xff))
+    done in
+  let u16 = le 2 and u32 = le 4 and u64 = le 8 in
+  let names = "\000.text\000.shstrtab\000" in
+  let text = 64 in
+  let strtab = text + String.length code in
+  let shoff = (strtab + String.length names + 7) land lnot 7 in
+  Buffer.add_string b "\x7fELF\x02\x01\x01";
+  Buffer.add_string b (String.make 9 '\x00');
+  u16 1; u16 62; u32 1; u64 0; u64 0; u64 shoff; u32 0;
+  u16 64; u16 0; u16 0; u16 64; u16 3; u16 2;
+  Buffer.add_string b code;
+  Buffer.add_string b names;
+  Buffer.add_string b (String.make (shoff - Buffer.length b) '\x00');
+  let section ~name ~typ ~flags ~off ~size ~align =
+    u32 name; u32 typ; u64 flags; u64 0; u64 off; u64 size;
+    u32 0; u32 0; u64 align; u64 0 in
+  Buffer.add_string b (String.make 64 '\x00');
+  section ~name:1 ~typ:1 ~flags:6 ~off:text
+    ~size:(String.length code) ~align:16;
+  section ~name:7 ~typ:3 ~flags:0 ~off:strtab
+    ~size:(String.length names) ~align:1;
+  Buffer.contents b
+
+(* a static archive in the GNU format, without a symbol table *)
+let archive members =
+  let b = Buffer.create 1024 in
+  Buffer.add_string b "!<arch>\n";
+  List.iter members ~f:(fun (name,data) ->
+      let size = String.length data in
+      Printf.bprintf b "%-16s%-12d%-6d%-6d%-8d%-10d`\n"
+        (name ^ "/") 0 0 0 644 size;
+      Buffer.add_string b data;
+      if size mod 2 = 1 then Buffer.add_char b '\n');
+  Buffer.contents b
+
+(* each member calls its own function:
+
+   0: call 6
+   5: ret
+   6: ret
+
+   Members are placed at page boundaries, so the function of the
+   second member is above the first page. *)
+let test_archive ctxt =
+  let code = "\xe8\x01\x00\x00\x00\xc3\xc3" in
+  let filename,out = bracket_tmpfile ~suffix:".a" ctxt in
+  Out_channel.output_string out @@ archive [
+    "one.o", elf_object code;
+    "two.o", elf_object code;
+  ];
+  Out_channel.close out;
+  let input = Project.Input.file ~loader:"llvm-archive" ~filename in
+  let p = Project.create input |> ok_exn in
+  let entries =
+    Project.symbols p |> Symtab.to_sequence |>
+    Seq.map ~f:(fun (_,entry,_) -> Block.addr entry) |>
+    Seq.to_list in
+  assert_bool "Expected more than one function" (List.length entries > 1);
+  let width = Addr.bitwidth (List.hd_exn entries) in
+  let page = Addr.of_int64 ~width 0x1000L in
+  assert_bool "Expected functions from several members" @@
+  List.exists entries ~f:(fun addr -> Addr.(addr >= page))
+
 let suite () = "Project" >::: [
+    "archive" >:: test_archive;
     "ARM" >::: test_substitute arm;
     "386" >::: test_substitute x86;
   ]
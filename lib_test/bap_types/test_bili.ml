@@ -31,18 +31,133 @@ let printer = function
   | Bil.Mem w -> "<memory>"
   | Bil.Imm w -> sprintf "%a" Word.pps w
 
+(* an interpreter with a mutable state  *)
+class ['a] paged_bili = object
+  inherit ['a] bili
+  method! empty = (new Bil.Storage.paged :> Bil.storage)
+end
+
+class flat_context = object
+  inherit Bili.context
+  inherit! Context.flat
+end
+
+(* each test is evaluated by the interpreter, with the persistent and
+   the mutable state, and by the compiler *)
 let assert_exp value exp ctxt =
-  assert_equal ~ctxt ~printer value (Exp.eval exp)
+  assert_equal ~ctxt ~printer value (Exp.eval exp);
+  assert_equal ~ctxt ~printer value (Bilc.compile_exp (Bilc.create ()) exp ())
 
 let assert_prg value prg ctxt =
   let open Monad.State.Monad_infix in
   let bili = new bili in
-  assert_equal ~ctxt ~printer value @@
-  let res = bili#eval prg >>= fun () -> bili#lookup r >>| Bil.Result.value in
-  Monad.State.eval res (new Bili.context)
+  assert_equal ~ctxt ~printer value @@ begin
+    let res = bili#eval prg >>= fun () -> bili#lookup r >>| Bil.Result.value in
+    Monad.State.eval res (new Bili.context)
+  end;
+  assert_equal ~ctxt ~printer value @@ begin
+    let bili = new paged_bili in
+    let res = bili#eval prg >>= fun () -> bili#lookup r >>| Bil.Result.value in
+    Monad.State.eval res (new flat_context)
+  end;
+  let regs = Bilc.create () in
+  Bilc.eval prg regs;
+  assert_equal ~ctxt ~printer value (Bilc.lookup regs r)
+
+let paged_storage ctxt =
+  let byte = Word.of_int ~width:8 in
+  let printer = function
+    | None -> "<none>"
+    | Some w -> Word.to_string w in
+  let s = new Bil.Storage.paged in
+  let s = s#save zero (byte 1) in
+  let c = s#copy in
+  let c = c#save zero (byte 2) in
+  let s = s#save one (byte 3) in
+  assert_equal ~ctxt ~printer (Some (byte 1)) (s#load zero);
+  assert_equal ~ctxt ~printer (Some (byte 2)) (c#load zero);
+  assert_equal ~ctxt ~printer (Some (byte 3)) (s#load one);
+  assert_equal ~ctxt ~printer None (c#load one);
+  assert_equal ~ctxt ~printer None (s#load two)
+
+(* as in other storages, addresses of different widths are different,
+   both for bytes and for wider words *)
+let paged_widths ctxt =
+  let byte = Word.of_int ~width:8 in
+  let half = Word.of_int ~width:16 in
+  let printer = function
+    | None -> "<none>"
+    | Some w -> Word.to_string w in
+  let wide = Word.of_int64 1L and other = Word.of_int64 2L in
+  let s = new Bil.Storage.paged in
+  let s = s#save one (byte 1) in
+  let s = s#save wide (byte 2) in
+  let s = s#save two (half 3) in
+  let s = s#save other (half 4) in
+  assert_equal ~ctxt ~printer (Some (byte 1)) (s#load one);
+  assert_equal ~ctxt ~printer (Some (byte 2)) (s#load wide);
+  assert_equal ~ctxt ~printer (Some (half 3)) (s#load two);
+  assert_equal ~ctxt ~printer (Some (half 4)) (s#load other);
+  let s = s#save two (byte 5) in
+  assert_equal ~ctxt ~printer (Some (byte 5)) (s#load two);
+  assert_equal ~ctxt ~printer (Some (half 4)) (s#load other)
+
+(* states, captured before a snapshot, are not affected by updates
+   of the states, that were derived from them *)
+let snapshot ctxt =
+  let byte = Word.of_int ~width:8 in
+  let result w = Bil.Result.word w Bil.Result.Id.zero in
+  let value c v = Option.map (c#lookup v) ~f:Bil.Result.value in
+  let loaded s x = Option.map (s#load x) ~f:word in
+  let printer = function
+    | None -> "<none>"
+    | Some v -> printer v in
+  let s = (new Bil.Storage.paged)#save zero (byte 1) in
+  let c = (new Context.flat)#update a (result (byte 1)) in
+  Context.snapshot ();
+  let s' = s#save zero (byte 2) in
+  let s' = s'#save one (byte 3) in
+  let c' = c#update a (result (byte 2)) in
+  let c' = c'#update b (result (byte 3)) in
+  assert_equal ~ctxt ~printer (Some (word (byte 1))) (loaded s zero);
+  assert_equal ~ctxt ~printer None (loaded s one);
+  assert_equal ~ctxt ~printer (Some (word (byte 2))) (loaded s' zero);
+  assert_equal ~ctxt ~printer (Some (word (byte 3))) (loaded s' one);
+  assert_equal ~ctxt ~printer (Some (word (byte 1))) (value c a);
+  assert_equal ~ctxt ~printer None (value c b);
+  assert_equal ~ctxt ~printer (Some (word (byte 2))) (value c' a);
+  assert_equal ~ctxt ~printer (Some (word (byte 3))) (value c' b)
+
+(* variables are bound in the order, that is different from the
+   order of their identifiers *)
+let flat ctxt =
+  let vars = List.init 100 ~f:(fun i ->
+      Var.create (sprintf "flat%d" i) reg32_t) |> List.rev in
+  let value v = Word.of_int ~width:32 (Var.id v) in
+  let result v = Bil.Result.word (value v) Bil.Result.Id.zero in
+  let lookup c v = match Option.map (c#lookup v) ~f:Bil.Result.value with
+    | Some (Bil.Imm w) -> Some w
+    | _ -> None in
+  let c = List.fold vars ~init:(new Context.flat) ~f:(fun c v ->
+      c#update v (result v)) in
+  let c' = c#copy#update a (result a) in
+  assert_equal ~ctxt ~printer:(List.to_string ~f:Var.to_string)
+    (List.sort ~cmp:Var.compare vars)
+    (Sequence.to_list c#bindings |> List.map ~f:fst);
+  List.iter vars ~f:(fun v ->
+      assert_equal ~ctxt ~cmp:(Option.equal Word.equal)
+        ~printer:(Option.value_map ~default:"<none>" ~f:Word.to_string)
+        (Some (value v)) (lookup c v));
+  assert_bool "Expected an unbound variable" (Option.is_none (c#lookup a));
+  assert_bool "Expected a bound variable" (Option.is_some (c'#lookup a))
 
 let suite () =
   "Bili" >::: [
+    "flat context" >:: flat;
+    "snapshot" >:: snapshot;
+    "paged storage" >:: paged_storage;
+    "paged storage widths" >:: paged_widths;
+
     "mem[0,el]:32 ~> bot" >::
     assert_exp undefined Bil.(load ~mem ~addr:(int one) el `r32);
 
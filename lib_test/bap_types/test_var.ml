@@ -0,0 +1,140 @@
+open Core_kernel.Std
+open OUnit2
+open Bap.Std
+
+let printer = Var.to_string
+
+let interned ctxt =
+  let x = Var.create "x" reg32_t in
+  let x' = Var.create "x" reg32_t in
+  let x64 = Var.create "x" reg64_t in
+  assert_bool "Expected the same variable" (phys_equal x x');
+  assert_equal ~ctxt ~printer:Int.to_string (Var.id x) (Var.id x');
+  assert_bool "Expected a different variable" (not (Var.equal x x64));
+  assert_equal ~ctxt ~printer x (Var.of_id (Var.id x));
+  assert_equal ~ctxt ~printer x (Var.base (Var.with_index x 2));
+  assert_bool "Expected the same base" (Var.same x (Var.with_index x 3))
+
+(* temporaries of each round are collected, so their identifiers are
+   reused, and do not grow with the number of rounds *)
+let recycled ctxt =
+  let size = 1000 and rounds = 32 in
+  let round () =
+    let vars = List.init size ~f:(fun _ ->
+        Var.create ~fresh:true "recycled" reg32_t) in
+    let last = List.fold vars ~init:0 ~f:(fun n v -> Int.max n (Var.id v)) in
+    Gc.full_major ();
+    last in
+  let first = round () in
+  let last = List.init rounds ~f:(fun _ -> round ()) |>
+             List.fold ~init:first ~f:Int.max in
+  assert_bool "Expected identifiers to be reused" @@
+  (last < first + rounds * size / 2)
+
+(* the variables are created in a different order by another process,
+   so their identifiers in that process are swapped. The child is
+   killed, once it has written them, so that it terminates without
+   running at_exit handlers of the test runner. *)
+let marshaled ctxt =
+  let names = ["marshaled_x"; "marshaled_y"] in
+  let create names =
+    List.map names ~f:(fun name -> Var.create name reg32_t) in
+  let rd,wr = Unix.pipe () in
+  Out_channel.flush stdout;
+  Out_channel.flush stderr;
+  match Unix.fork () with
+  | 0 ->
+    Unix.close rd;
+    let vars = create (List.rev names) in
+    let out = Unix.out_channel_of_descr wr in
+    Marshal.to_channel out (vars : var list) [];
+    Out_channel.close out;
+    Unix.kill (Unix.getpid ()) Sys.sigkill;
+    assert false
+  | pid ->
+    Unix.close wr;
+    let vars = create names in
+    let input = Unix.in_channel_of_descr rd in
+    let read : var list = Marshal.from_channel input in
+    In_channel.close input;
+    ignore (Unix.waitpid [] pid);
+    let read = List.rev read in
+    List.iter2_exn vars read ~f:(fun v v' ->
+        assert_equal ~ctxt ~printer v v';
+        assert_equal ~ctxt ~printer:Int.to_string (Var.id v) (Var.id v');
+        assert_equal ~ctxt ~printer:Int.to_string
+          (Var.hash v) (Var.hash v'));
+    assert_bool "Expected marshaled variables to be found" @@
+    List.for_all read ~f:(Set.mem (Var.Set.of_list vars))
+
+let vars = List.init 200 ~f:(fun i -> Var.create (sprintf "v%d" i) reg32_t)
+let evens = List.filter vars ~f:(fun v -> Var.id v mod 2 = 0)
+let odds = List.filter vars ~f:(fun v -> Var.id v mod 2 = 1)
+
+let bitset ctxt =
+  let module S = Var.Bitset in
+  let printer s = Var.Set.sexp_of_t (S.to_set s) |> Sexp.to_string in
+  let assert_set expect set =
+    assert_equal ~ctxt ~printer ~cmp:S.equal (S.of_list expect) set in
+  let all = S.of_list vars in
+  let even = S.of_list evens and odd = S.of_set (Var.Set.of_list odds) in
+  let x = List.hd_exn vars and y = List.last_exn vars in
+  assert_equal ~ctxt ~printer:Int.to_string 200 (S.length all);
+  assert_bool "Expected a member" (S.mem all x && S.mem all y);
+  assert_bool "Expected no members" (not (S.mem S.empty x));
+  assert_set vars (S.union even odd);
+  assert_set [] (S.inter even odd);
+  assert_set evens (S.diff all odd);
+  assert_set [x] (S.singleton x);
+  assert_set [y] (S.remove (S.of_list [x;y]) x);
+  assert_set [x;y] (S.add (S.singleton y) x);
+  assert_bool "Expected empty" (S.is_empty (S.remove (S.singleton y) y));
+  assert_bool "Expected a subset" (S.subset even all);
+  assert_bool "Expected not a subset" (not (S.subset all even));
+  assert_equal ~ctxt ~printer:(List.to_string ~f:Var.to_string)
+    (List.sort ~cmp:Var.compare vars) (S.elements all);
+  assert_bool "Expected the same set" @@
+  Var.Set.equal (Var.Set.of_list vars) (S.to_set all)
+
+let array_map ctxt =
+  let module M = Var.Array_map in
+  let printer = Option.value_map ~default:"<none>" ~f:Int.to_string in
+  let m = M.create () in
+  List.iter vars ~f:(fun v -> M.set m ~key:v ~data:(Var.id v));
+  let c = M.copy m in
+  List.iter evens ~f:(M.remove m);
+  List.iter vars ~f:(fun v ->
+      let expect = if Var.id v mod 2 = 0 then None else Some (Var.id v) in
+      assert_equal ~ctxt ~printer expect (M.find m v);
+      assert_equal ~ctxt ~printer (Some (Var.id v)) (M.find c v));
+  assert_equal ~ctxt ~printer:Int.to_string (List.length odds)
+    (M.fold m ~init:0 ~f:(fun ~key ~data n ->
+         assert_equal ~ctxt ~printer (Some (Var.id key)) (Some data);
+         n + 1))
+
+(* [x] is defined in the entry, that dominates its use, [y] and [z]
+   are not defined *)
+let free_vars ctxt =
+  let x = Var.create "x" reg32_t and y = Var.create "y" reg32_t in
+  let z = Var.create "z" reg32_t and r = Var.create "r" reg32_t in
+  let exit = Term.append def_t (Blk.create ())
+      (Def.create r Bil.(var x + var y + var z)) in
+  let entry =
+    Term.append def_t (Blk.create ())
+      (Def.create x Bil.(int (Word.of_int32 1l))) |> fun b ->
+    Term.append jmp_t b (Jmp.create_goto (Label.direct (Term.tid exit))) in
+  let sub = List.fold [entry; exit] ~init:(Sub.create ~name:"f" ())
+      ~f:(fun sub blk -> Term.append blk_t sub blk) in
+  let printer s = Var.Set.sexp_of_t s |> Sexp.to_string in
+  assert_equal ~ctxt ~printer ~cmp:Var.Set.equal
+    (Var.Set.of_list [y; z]) (Sub.free_vars sub)
+
+let suite () =
+  "Var" >::: [
+    "interned" >:: interned;
+    "recycled" >:: recycled;
+    "marshaled" >:: marshaled;
+    "bitset" >:: bitset;
+    "array map" >:: array_map;
+    "free vars" >:: free_vars;
+  ]
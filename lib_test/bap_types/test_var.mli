@@ -0,0 +1,2 @@
+open OUnit2
+val suite : unit -> test
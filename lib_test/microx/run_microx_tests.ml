@@ -0,0 +1,4 @@
+open OUnit2
+
+let () =
+  run_test_tt_main Test_conqueror.suite
@@ -0,0 +1,60 @@
+open Core_kernel.Std
+open OUnit2
+open Bap.Std
+open Microx.Std
+
+let x = Var.create "x" reg32_t
+let mem = Var.create "mem" (mem32_t `r8)
+let lr = Var.create "LR" reg32_t
+
+let addr = Bil.int (Word.of_int32 0l)
+let zero = Bil.int (Word.of_int32 0l)
+let byte n = Bil.int (Word.of_int ~width:8 n)
+let store n = Bil.(store ~mem:(var mem) ~addr (byte n) LittleEndian `r8)
+let load = Bil.(load ~mem:(var mem) ~addr LittleEndian `r8)
+
+let blk defs jmps =
+  let b = List.fold defs ~init:(Blk.create ()) ~f:(fun b (v,e) ->
+      Term.append def_t b (Def.create v e)) in
+  List.fold jmps ~init:b ~f:(fun b j -> Term.append jmp_t b j)
+
+let goto ?cond b = Jmp.create_goto ?cond (Label.direct (Term.tid b))
+
+(* entry stores a byte and branches to either [left], that stores
+   another byte, or [right], that loads it. Both reach [exit], that
+   returns to an unknown address, so the explorer has to backtrack
+   to the branch, that was not taken.  *)
+let exit = blk [] [Jmp.create_ret (Label.indirect Bil.(var lr))]
+let left = blk [mem, store 1] [goto exit]
+let right = blk [Var.create "y" reg8_t, load] [goto exit]
+let entry = blk [mem, store 0; x, zero] [
+    goto ~cond:Bil.(var x = zero) left;
+    goto right;
+  ]
+
+let sub =
+  List.fold [entry; left; right; exit]
+    ~init:(Sub.create ~name:"f" ()) ~f:(fun s b -> Term.append blk_t s b)
+
+let prog = Term.append sub_t (Program.create ()) sub
+
+let visited ctxt interp =
+  Monad.State.exec (interp#eval_sub sub) ctxt |> fun ctxt ->
+  Map.keys ctxt#visited |> Tid.Set.of_list
+
+let forkable ctxt =
+  let printer set =
+    Set.to_list set |> List.map ~f:Tid.to_string |> String.concat ~sep:" " in
+  let expect =
+    visited (new Conqueror.context prog) (new Conqueror.main prog) in
+  let got =
+    visited (new Conqueror.forkable prog)
+      (new Conqueror.main ~paged:true prog) in
+  List.iter [entry; left; right; exit] ~f:(fun blk ->
+      assert_bool "Expected all blocks to be visited"
+        (Set.mem expect (Term.tid blk)));
+  assert_equal ~ctxt ~printer expect got
+
+let suite = "Conqueror" >::: [
+    "forkable" >:: forkable;
+  ]
@@ -0,0 +1 @@
+val suite : OUnit2.test
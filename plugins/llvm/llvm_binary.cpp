@@ -9,6 +9,30 @@ extern "C" {
         delete m;
     }
 
+    const ar::archive* archive_create(const char* data, size_t size) {
+        return ar::create(data, size);
+    }
+
+    void archive_destroy(const ar::archive* a) {
+        delete a;
+    }
+
+    size_t archive_member_count(const ar::archive* a) {
+        return a->size();
+    }
+
+    const char* archive_member_name(const ar::archive* a, size_t i) {
+        return (*a)[i].name().c_str();
+    }
+
+    uint64_t archive_member_offset(const ar::archive* a, size_t i) {
+        return (*a)[i].offset();
+    }
+
+    uint64_t archive_member_size(const ar::archive* a, size_t i) {
+        return (*a)[i].size();
+    }
+
     const char* image_arch(const img::image* m) {
         return (llvm::Triple::getArchTypeName(m->arch()));
     }
@@ -74,7 +98,11 @@ extern "C" {
     }
 
     const char* section_name(const sec::section* s) {
-        return s->name().c_str();
+        return s->name().data();
+    }
+
+    size_t section_name_size(const sec::section* s) {
+        return s->name().size();
     }
 
     uint64_t section_addr(const sec::section* s) {
@@ -86,7 +114,11 @@ extern "C" {
     }
 
     const char* symbol_name(const sym::symbol* s) {
-        return s->name().c_str();
+        return s->name().data();
+    }
+
+    size_t symbol_name_size(const sym::symbol* s) {
+        return s->name().size();
     }
 
     int symbol_kind(const sym::symbol* s) {
@@ -5,6 +5,14 @@ struct image;
 struct section;
 struct symbol;
 struct segment;
+struct archive;
+
+const struct archive* archive_create(const char*, size_t);
+void archive_destroy(const struct archive*);
+size_t archive_member_count(const struct archive*);
+const char* archive_member_name(const struct archive*, size_t);
+uint64_t archive_member_offset(const struct archive*, size_t);
+uint64_t archive_member_size(const struct archive*, size_t);
 
 const struct image* image_create(const char*, size_t);
 void image_destroy(const struct image*);
@@ -26,11 +34,15 @@ bool segment_is_readable(const struct segment*);
 bool segment_is_writable(const struct segment*);
 bool segment_is_executable(const struct segment*);
 
+/* section and symbol names are not null-terminated, they point
+   into the image data. */
 const char* section_name(const struct section*);
+size_t section_name_size(const struct section*);
 uint64_t section_addr(const struct section*);
 uint64_t section_size(const struct section*);
 
 const char* symbol_name(const struct symbol*);
+size_t symbol_name_size(const struct symbol*);
 int symbol_kind(const struct symbol*);
 uint64_t symbol_addr(const struct symbol*);
 uint64_t symbol_size(const struct symbol*);
@@ -1,6 +1,7 @@
 #ifndef LLVM_BINARY_HPP
 #define LLVM_BINARY_HPP
 
+#include <map>
 #include <memory>
 #include <numeric>
 #include <vector>
@@ -67,6 +68,36 @@ std::vector<MachOObjectFile::LoadCommandInfo> load_commands(const MachOObjectFil
     return cmds;
 }
 
+typedef error_code (SectionRef::*section_predicate)(bool&) const;
+
+bool section_is(const SectionRef& sec, section_predicate pred) {
+    bool result = false;
+    if (error_code ec = (sec.*pred)(result))
+        llvm_binary_fail(ec);
+    return result;
+}
+
+// position of the section contents in the object file
+uint64_t file_offset(const ObjectFile& obj, const SectionRef& sec) {
+    StringRef contents;
+    if (error_code ec = sec.getContents(contents))
+        llvm_binary_fail(ec);
+    return contents.data() - obj.getData().data();
+}
+
+// Relocatable objects have neither program headers nor section
+// addresses, so their allocatable sections are mapped at their
+// file offsets, which are unique in the object.
+template <typename T>
+bool is_relocatable(const ELFObjectFile<T>& obj) {
+    return obj.getELFFile()->getHeader()->e_type == ELF::ET_REL;
+}
+
+bool is_mapped(const SectionRef& sec) {
+    return section_is(sec, &SectionRef::isRequiredForExecution) &&
+        !section_is(sec, &SectionRef::isBSS);
+}
+
 const pe32plus_header* getPE32PlusHeader(const COFFObjectFile& obj) {
     uint64_t cur_ptr = 0;
     const char * buf = (obj.getData()).data();
@@ -121,6 +152,16 @@ struct segment {
         name_ = oss.str();
     }
 
+    segment(const std::string &name, uint64_t offset, uint64_t addr,
+            uint64_t size, bool is_writable, bool is_executable)
+        : name_(name)
+        , offset_(offset)
+        , addr_(addr)
+        , size_(size)
+        , is_readable_(true)
+        , is_writable_(is_writable)
+        , is_executable_(is_executable) {}
+
     segment(const MachO::segment_command &s) {
         init_macho_segment(s);
     }
@@ -186,8 +227,36 @@ private:
     bool is_executable_;
 };
 
+template<typename T>
+std::vector<segment> read_relocatable(const ELFObjectFile<T>& obj) {
+    std::vector<segment> segments;
+    int pos = 0;
+    for (auto it = obj.begin_sections();
+         it != obj.end_sections(); ++it, ++pos) {
+        uint64_t size;
+        if (error_code ec = it->getSize(size))
+            llvm_binary_fail(ec);
+        if (size == 0 || !utils::is_mapped(*it))
+            continue;
+        bool is_text = utils::section_is(*it, &SectionRef::isText);
+        bool is_rodata = utils::section_is(*it, &SectionRef::isReadOnlyData);
+        uint64_t offset = utils::file_offset(obj, *it);
+        std::ostringstream oss;
+        oss << std::setfill('0') << std::setw(2) << pos ;
+        segments.push_back(segment(oss.str(), offset, offset, size,
+                                   !is_text && !is_rodata, is_text));
+    }
+    std::sort(segments.begin(), segments.end(),
+              [](const segment &x, const segment &y) {
+                  return x.offset() < y.offset();
+              });
+    return segments;
+}
+
 template<typename T>
 std::vector<segment> read(const ELFObjectFile<T>& obj) {
+    if (utils::is_relocatable(obj))
+        return read_relocatable(obj);
     auto begin = obj.getELFFile()->begin_program_headers();
     auto end = obj.getELFFile()->end_program_headers();
     std::vector<segment> segments;
@@ -274,10 +343,8 @@ struct symbol {
     }
 
     explicit symbol(const SymbolRef& sym) {
-        StringRef name;
-        if(error_code err = sym.getName(name))
+        if(error_code err = sym.getName(this->name_))
             llvm_binary_fail(err);
-        this->name_ = name.str();
 
         if (error_code err = sym.getType(this->kind_))
             llvm_binary_fail(err);
@@ -290,12 +357,13 @@ struct symbol {
     }
 
 
-    const std::string& name() const { return name_; }
+    // points into the object file data, that must outlive the image
+    StringRef name() const { return name_; }
     kind_type kind() const { return kind_; }
     uint64_t addr() const { return addr_; }
     uint64_t size() const { return size_; }
 private:
-    std::string name_;
+    StringRef name_;
     kind_type kind_;
     uint64_t addr_;
     uint64_t size_;
@@ -322,50 +390,41 @@ std::vector<symbol> read(const ObjectFile& obj) {
 }
 
 
-std::vector<symbol> readPE32Plus(const COFFObjectFile& obj) {
-    std::vector<symbol> symbols;
-
-    const pe32plus_header *pe32plus = utils::getPE32PlusHeader(obj);
-    if (!pe32plus)
-	llvm_binary_fail("Failed to extract PE32+ header");
-
-    for (auto it = obj.begin_symbols(); it != obj.end_symbols(); ++it) {
-	auto sym = obj.getCOFFSymbol(it);
-
-	if (!sym) llvm_binary_fail("not a coff symbol");
-
-	const coff_section *sec = nullptr;
-	if (sym->SectionNumber == COFF::IMAGE_SYM_UNDEFINED)
-	    continue;
-
-	if (error_code ec = obj.getSection(sym->SectionNumber, sec))
-	    llvm_binary_fail(ec);
-
-	if (!sec) continue;
-
-	uint64_t size = (sec->VirtualAddress + sec->SizeOfRawData) - sym->Value;
-
-	for (auto it = obj.begin_symbols(); it != obj.end_symbols(); ++it) {
-	    auto next = obj.getCOFFSymbol(it);
-	    if (next->SectionNumber == sym->SectionNumber) {
-                auto new_size = next->Value > sym->Value ?
-                    next->Value - sym->Value : size;
-                size = new_size < size ? new_size : size;
-	    }
-	}
+// for each section, the sorted offsets of all symbols defined in it,
+// so that the size of a symbol can be found by a binary search for
+// the next symbol, instead of by a scan of the whole symbol table.
+struct coff_offsets {
+    explicit coff_offsets(const COFFObjectFile& obj) {
+        for (auto it = obj.begin_symbols(); it != obj.end_symbols(); ++it) {
+            auto sym = obj.getCOFFSymbol(it);
+            if (!sym) llvm_binary_fail("not a coff symbol");
+            offsets_[sym->SectionNumber].push_back(sym->Value);
+        }
+        for (auto &sec : offsets_)
+            std::sort(sec.second.begin(), sec.second.end());
+    }
 
-	auto addr = sec->VirtualAddress + pe32plus->ImageBase + sym->Value;
-	symbols.push_back(symbol(*it,addr,size));
+    // the distance from [sym] to the next symbol of the same section,
+    // or [size] if there is no such symbol or it is further than [size].
+    uint64_t size(const coff_symbol *sym, uint64_t size) const {
+        auto sec = offsets_.find(sym->SectionNumber);
+        if (sec == offsets_.end())
+            return size;
+        const std::vector<uint64_t> &offs = sec->second;
+        uint64_t value = sym->Value;
+        auto next = std::upper_bound(offs.begin(), offs.end(), value);
+        if (next == offs.end())
+            return size;
+        return std::min(*next - value, size);
     }
-    return symbols;
-}
 
-std::vector<symbol> readPE32(const COFFObjectFile& obj) {
-    std::vector<symbol> symbols;
+private:
+    std::map<int, std::vector<uint64_t> > offsets_;
+};
 
-    const pe32_header *pe32;
-    if (error_code err = obj.getPE32Header(pe32))
-        llvm_binary_fail(err);
+std::vector<symbol> read_coff(const COFFObjectFile& obj, uint64_t image_base) {
+    std::vector<symbol> symbols;
+    coff_offsets offsets(obj);
 
     for (auto it = obj.begin_symbols(); it != obj.end_symbols(); ++it) {
         auto sym = obj.getCOFFSymbol(it);
@@ -382,22 +441,28 @@ std::vector<symbol> readPE32(const COFFObjectFile& obj) {
         if (!sec) continue;
 
         uint64_t size = (sec->VirtualAddress + sec->SizeOfRawData) - sym->Value;
+        size = offsets.size(sym, size);
 
-        for (auto it = obj.begin_symbols(); it != obj.end_symbols(); ++it) {
-            auto next = obj.getCOFFSymbol(it);
-            if (next->SectionNumber == sym->SectionNumber) {
-                auto new_size = next->Value > sym->Value ?
-                    next->Value - sym->Value : size;
-                size = new_size < size ? new_size : size;
-            }
-        }
-
-        auto addr = sec->VirtualAddress + pe32->ImageBase + sym->Value;
+        auto addr = sec->VirtualAddress + image_base + sym->Value;
         symbols.push_back(symbol(*it,addr,size));
     }
     return symbols;
 }
 
+std::vector<symbol> readPE32Plus(const COFFObjectFile& obj) {
+    const pe32plus_header *pe32plus = utils::getPE32PlusHeader(obj);
+    if (!pe32plus)
+	llvm_binary_fail("Failed to extract PE32+ header");
+    return read_coff(obj, pe32plus->ImageBase);
+}
+
+std::vector<symbol> readPE32(const COFFObjectFile& obj) {
+    const pe32_header *pe32;
+    if (error_code err = obj.getPE32Header(pe32))
+        llvm_binary_fail(err);
+    return read_coff(obj, pe32->ImageBase);
+}
+
 std::vector<symbol> read(const COFFObjectFile& obj) {
     if (obj.getBytesInAddress() == 4) {
 	return readPE32(obj);
@@ -406,8 +471,30 @@ std::vector<symbol> read(const COFFObjectFile& obj) {
     }
 }
 
+// symbol values of a relocatable object are relative to their
+// sections, see utils::is_relocatable
+template <typename ELFT>
+std::vector<symbol> read_relocatable(const ELFObjectFile<ELFT>& obj) {
+    std::vector<symbol> symbols;
+    for (auto it = obj.begin_symbols(); it != obj.end_symbols(); ++it) {
+        symbol sym(*it);
+        section_iterator sec = obj.end_sections();
+        if (error_code ec = it->getSection(sec))
+            llvm_binary_fail(ec);
+        if (sec != obj.end_sections() && utils::is_mapped(*sec)) {
+            uint64_t addr = sym.addr() + utils::file_offset(obj, *sec);
+            symbols.push_back(symbol(*it, addr, sym.size()));
+        } else {
+            symbols.push_back(sym);
+        }
+    }
+    return symbols;
+}
+
 template <typename ELFT>
 std::vector<symbol> read(const ELFObjectFile<ELFT>& obj) {
+    if (utils::is_relocatable(obj))
+        return read_relocatable(obj);
     int size1 = utils::distance(obj.begin_symbols(),
                                 obj.end_symbols());
     int size2 = utils::distance(obj.begin_dynamic_symbols(),
@@ -435,22 +522,25 @@ using namespace llvm::object;
 
 struct section {
     explicit section(const SectionRef& sec) {
-        StringRef name;
-        if(error_code err = sec.getName(name))
+        if(error_code err = sec.getName(this->name_))
             llvm_binary_fail(err);
-        this->name_ = name.str();
         if (error_code err = sec.getAddress(this->addr_))
             llvm_binary_fail(err);
 
         if (error_code err = sec.getSize(this->size_))
             llvm_binary_fail(err);
     }
-    const std::string& name() const { return name_; }
+
+    section(const SectionRef& sec, uint64_t addr) : section(sec) {
+        addr_ = addr;
+    }
+    // points into the object file data, that must outlive the image
+    StringRef name() const { return name_; }
     uint64_t addr() const { return addr_; }
     uint64_t size() const { return size_; }
 
 private:
-    std::string name_;
+    StringRef name_;
     uint64_t addr_;
     uint64_t size_;
 };
@@ -467,6 +557,20 @@ std::vector<section> read(const ObjectFile& obj) {
     return sections;
 }
 
+template <typename ELFT>
+std::vector<section> read(const ELFObjectFile<ELFT>& obj) {
+    if (!utils::is_relocatable(obj))
+        return read(static_cast<const ObjectFile&>(obj));
+    std::vector<section> sections;
+    for (auto it = obj.begin_sections(); it != obj.end_sections(); ++it) {
+        if (utils::is_mapped(*it))
+            sections.push_back(section(*it, utils::file_offset(obj, *it)));
+        else
+            sections.push_back(section(*it));
+    }
+    return sections;
+}
+
 } //namespace sec
 
 namespace img {
@@ -606,7 +710,7 @@ image* create_image_obj(std::unique_ptr<object::Binary> binary) {
 }
 
 image* create_image_arch(std::unique_ptr<object::Binary> binary) {
-    llvm_binary_fail("Archive loading unimplemented");
+    llvm_binary_fail("Archive members should be loaded separately");
 }
 
 image* create(std::unique_ptr<object::Binary> binary) {
@@ -617,9 +721,11 @@ image* create(std::unique_ptr<object::Binary> binary) {
     llvm_binary_fail("Unrecognized binary format");
 }
 
+// the buffer doesn't own the data, so the caller must keep
+// [data] alive for the whole lifetime of the image.
 image* create(const char* data, std::size_t size) {
     StringRef data_ref(data, size);
-    MemoryBuffer* buff(MemoryBuffer::getMemBufferCopy(data_ref, "binary"));
+    MemoryBuffer* buff(MemoryBuffer::getMemBuffer(data_ref, "binary", false));
     OwningPtr<object::Binary> bin;
     if (error_code ec = createBinary(buff, bin))
         llvm_binary_fail(ec);
@@ -629,4 +735,42 @@ image* create(const char* data, std::size_t size) {
 
 } //namespace img
 
+namespace ar {
+using namespace llvm;
+using namespace llvm::object;
+
+// a member of an archive is a slice of the archive data
+struct member {
+    member(const std::string &name, uint64_t offset, uint64_t size)
+        : name_(name), offset_(offset), size_(size) {}
+    const std::string& name() const { return name_; }
+    uint64_t offset() const { return offset_; }
+    uint64_t size() const { return size_; }
+private:
+    std::string name_;
+    uint64_t offset_;
+    uint64_t size_;
+};
+
+typedef std::vector<member> archive;
+
+archive* create(const char* data, std::size_t size) {
+    StringRef data_ref(data, size);
+    error_code ec;
+    Archive arch(MemoryBuffer::getMemBuffer(data_ref, "archive", false), ec);
+    if (ec)
+        llvm_binary_fail(ec);
+    std::unique_ptr<archive> members(new archive());
+    for (auto it = arch.begin_children(); it != arch.end_children(); ++it) {
+        StringRef name;
+        if (error_code err = it->getName(name))
+            llvm_binary_fail(err);
+        StringRef buf = it->getBuffer();
+        members->push_back(member(name.str(), buf.data() - data, buf.size()));
+    }
+    return members.release();
+}
+
+} //namespace ar
+
 #endif //LLVM_BINARY_HPP
@@ -4,6 +4,8 @@ open Core_kernel.Std
 
 module LLVM = Llvm_types
 
+(* LLVM doesn't copy the data, so the image keeps it reachable for
+   as long as the image is alive. *)
 type t
 
 external create : Bigstring.t -> t =
@@ -18,8 +20,28 @@ external entry : t -> int64 =
 external segments : t -> LLVM.Segment.t list =
   "llvm_binary_segments_stub"
 
-external symbols : t -> LLVM.Symbol.t list =
-  "llvm_binary_symbols_stub"
+external symbols_count : t -> int =
+  "llvm_binary_symbols_count_stub" "noalloc"
 
-external sections : t -> LLVM.Section.t list =
-  "llvm_binary_sections_stub"
+external symbol : t -> int -> LLVM.Symbol.t =
+  "llvm_binary_symbol_stub"
+
+external symbol_size : t -> int -> int64 =
+  "llvm_binary_symbol_size_stub"
+
+external sections_count : t -> int =
+  "llvm_binary_sections_count_stub" "noalloc"
+
+external section : t -> int -> LLVM.Section.t =
+  "llvm_binary_section_stub"
+
+external archive_members : Bigstring.t -> (string * int * int) list =
+  "llvm_binary_archive_members_stub"
+
+let members data =
+  archive_members data |> List.map ~f:(fun (name,pos,len) ->
+      name, Bigstring.sub_shared ~pos ~len data)
+
+let symbols t = List.init (symbols_count t) ~f:(symbol t)
+
+let sections t = List.init (sections_count t) ~f:(section t)
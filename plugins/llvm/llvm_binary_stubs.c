@@ -6,6 +6,8 @@
 #include <caml/compatibility.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "llvm_binary_stubs.h"
 #include "llvm_binary.h"
@@ -14,18 +16,31 @@ Noreturn void llvm_binary_fail(const char* message) {
     caml_failwith(message);
 }
 
+/* LLVM doesn't copy the data of an image, so the image holds its
+ * data with a global root. The root can't be stored in the custom
+ * block itself, since the block may be moved by the GC. */
+struct image_handle {
+    const struct image* img;
+    value data;
+};
+
+static struct image_handle* handle_from_value(value v) {
+    return *(struct image_handle**) Data_custom_val(v);
+}
+
 static const struct image* image_from_value(value v) {
-    return *(const struct image**) Data_custom_val(v);
+    return handle_from_value(v)->img;
 }
 
 static void custom_finalize_image(value v) {
-    CAMLparam1(v);
-    image_destroy(image_from_value(v));
-    CAMLreturn0;
+    struct image_handle* h = handle_from_value(v);
+    image_destroy(h->img);
+    caml_remove_generational_global_root(&h->data);
+    free(h);
 }
 
-static value image_to_value(const struct image* img) {
-    CAMLparam0();
+static value image_to_value(const struct image* img, value data) {
+    CAMLparam1(data);
     CAMLlocal1(v);
     static struct custom_operations binary_ops = {
         "bap.llvm_loader",
@@ -35,8 +50,16 @@ static value image_to_value(const struct image* img) {
         custom_serialize_default,
         custom_deserialize_default
     };
-    v = alloc_custom(&binary_ops, sizeof(struct image*), 0, 1);
-    *((const struct image**)(Data_custom_val(v))) = img;
+    struct image_handle* h = malloc(sizeof(struct image_handle));
+    if (!h) {
+        image_destroy(img);
+        caml_raise_out_of_memory();
+    }
+    h->img = img;
+    h->data = data;
+    caml_register_generational_global_root(&h->data);
+    v = alloc_custom(&binary_ops, sizeof(struct image_handle*), 0, 1);
+    *((struct image_handle**)(Data_custom_val(v))) = h;
     CAMLreturn(v);
 }
 
@@ -54,11 +77,19 @@ static value segment_to_value(const struct segment* s) {
     CAMLreturn(result);
 }
 
+static value copy_name(const char* name, size_t size) {
+    CAMLparam0();
+    CAMLlocal1(result);
+    result = caml_alloc_string(size);
+    memcpy(String_val(result), name, size);
+    CAMLreturn(result);
+}
+
 static value section_to_value(const struct section* s) {
     CAMLparam0();
     CAMLlocal1(result);
     result = caml_alloc(3, 0);
-    Store_field(result, 0, caml_copy_string(section_name(s)));
+    Store_field(result, 0, copy_name(section_name(s), section_name_size(s)));
     Store_field(result, 1, caml_copy_int64(section_addr(s)));
     Store_field(result, 2, caml_copy_int64(section_size(s)));
     CAMLreturn(result);
@@ -68,7 +99,7 @@ static value symbol_to_value(const struct symbol* s) {
     CAMLparam0();
     CAMLlocal1(result);
     result = caml_alloc(4, 0);
-    Store_field(result, 0, caml_copy_string(symbol_name(s)));
+    Store_field(result, 0, copy_name(symbol_name(s), symbol_name_size(s)));
     Store_field(result, 1, Val_int(symbol_kind(s)));
     Store_field(result, 2, caml_copy_int64(symbol_addr(s)));
     Store_field(result, 3, caml_copy_int64(symbol_size(s)));
@@ -76,21 +107,6 @@ static value symbol_to_value(const struct symbol* s) {
 
 }
 
-static value image_sections_to_value(const struct image* img) {
-    CAMLparam0();
-    CAMLlocal2(result, cons);
-    result = Val_emptylist;
-    size_t i = image_section_count(img);
-    while (i != 0) {
-        cons = caml_alloc(2, 0);
-        Store_field(cons, 0,
-                    section_to_value(image_section_from_index(img, --i)));// head
-        Store_field(cons, 1, result); // tail
-        result = cons;
-    }
-    CAMLreturn (result);
-}
-
 static value image_segments_to_value(const struct image* img) {
     CAMLparam0();
     CAMLlocal2(result, cons);
@@ -106,21 +122,43 @@ static value image_segments_to_value(const struct image* img) {
     CAMLreturn (result);
 }
 
-static value image_symbols_to_value(const struct image* img) {
+static value archive_member_to_value(const struct archive* a, size_t i) {
+    CAMLparam0();
+    CAMLlocal1(result);
+    result = caml_alloc_tuple(3);
+    Store_field(result, 0, caml_copy_string(archive_member_name(a, i)));
+    Store_field(result, 1, Val_long(archive_member_offset(a, i)));
+    Store_field(result, 2, Val_long(archive_member_size(a, i)));
+    CAMLreturn(result);
+}
+
+static value archive_members_to_value(const struct archive* a) {
     CAMLparam0();
     CAMLlocal2(result, cons);
     result = Val_emptylist;
-    size_t i = image_symbol_count(img);
+    size_t i = archive_member_count(a);
     while (i != 0) {
         cons = caml_alloc(2, 0);
-        Store_field (cons, 0,
-                     symbol_to_value(image_symbol_from_index(img, --i)));// head
-        Store_field (cons, 1, result); // tail
+        Store_field(cons, 0, archive_member_to_value(a, --i)); // head
+        Store_field(cons, 1, result); // tail
         result = cons;
     }
     CAMLreturn (result);
 }
 
+CAMLprim value llvm_binary_archive_members_stub(value arg) {
+    CAMLparam1(arg);
+    CAMLlocal1(result);
+    const struct caml_ba_array* array = Caml_ba_array_val(arg);
+    if (array->num_dims != 1)
+        caml_invalid_argument("invalid bigarray dimension");
+    const struct archive* a =
+        archive_create((const char*)(array->data), array->dim[0]);
+    result = archive_members_to_value(a);
+    archive_destroy(a);
+    CAMLreturn(result);
+}
+
 CAMLprim value llvm_binary_create_stub(value arg) {
     CAMLparam1(arg);
     const struct caml_ba_array* array = Caml_ba_array_val(arg);
@@ -128,7 +166,7 @@ CAMLprim value llvm_binary_create_stub(value arg) {
         caml_invalid_argument("invalid bigarray dimension");
     const struct image* obj =
         image_create((const char*)(array->data), array->dim[0]);
-    CAMLreturn(image_to_value(obj));
+    CAMLreturn(image_to_value(obj, arg));
 }
 
 CAMLprim value llvm_binary_arch_stub(value arg) {
@@ -146,12 +184,39 @@ CAMLprim value llvm_binary_segments_stub(value arg) {
     CAMLreturn(image_segments_to_value(image_from_value(arg)));
 }
 
-CAMLprim value llvm_binary_symbols_stub(value arg) {
-    CAMLparam1(arg);
-    CAMLreturn(image_symbols_to_value(image_from_value(arg)));
+static const struct symbol* symbol_from_value(value img, value n) {
+    const struct image* obj = image_from_value(img);
+    if (Long_val(n) < 0 || (size_t)Long_val(n) >= image_symbol_count(obj))
+        caml_invalid_argument("symbol index out of bounds");
+    return image_symbol_from_index(obj, Long_val(n));
 }
 
-CAMLprim value llvm_binary_sections_stub(value arg) {
-    CAMLparam1(arg);
-    CAMLreturn(image_sections_to_value(image_from_value(arg)));
+static const struct section* section_from_value(value img, value n) {
+    const struct image* obj = image_from_value(img);
+    if (Long_val(n) < 0 || (size_t)Long_val(n) >= image_section_count(obj))
+        caml_invalid_argument("section index out of bounds");
+    return image_section_from_index(obj, Long_val(n));
+}
+
+CAMLprim value llvm_binary_symbols_count_stub(value arg) {
+    return Val_long(image_symbol_count(image_from_value(arg)));
+}
+
+CAMLprim value llvm_binary_symbol_stub(value arg, value n) {
+    CAMLparam2(arg, n);
+    CAMLreturn(symbol_to_value(symbol_from_value(arg, n)));
+}
+
+CAMLprim value llvm_binary_symbol_size_stub(value arg, value n) {
+    CAMLparam2(arg, n);
+    CAMLreturn(caml_copy_int64(symbol_size(symbol_from_value(arg, n))));
+}
+
+CAMLprim value llvm_binary_sections_count_stub(value arg) {
+    return Val_long(image_section_count(image_from_value(arg)));
+}
+
+CAMLprim value llvm_binary_section_stub(value arg, value n) {
+    CAMLparam2(arg, n);
+    CAMLreturn(section_to_value(section_from_value(arg, n)));
 }
@@ -4,12 +4,16 @@
 extern "C" {
 #endif
 
+    value llvm_binary_archive_members_stub(value);
     value llvm_binary_create_stub(value);
     value llvm_binary_arch_stub(value);
     value llvm_binary_entry_stub(value);
     value llvm_binary_segments_stub(value);
-    value llvm_binary_symbols_stub(value);
-    value llvm_binary_sections_stub(value);
+    value llvm_binary_symbols_count_stub(value);
+    value llvm_binary_symbol_stub(value, value);
+    value llvm_binary_symbol_size_stub(value, value);
+    value llvm_binary_sections_count_stub(value);
+    value llvm_binary_section_stub(value, value);
 
 #ifdef __cplusplus 
 }
@@ -14,6 +14,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <unordered_map>
 
 #include "disasm.hpp"
 #include "llvm_disasm.h"
@@ -96,6 +97,8 @@ static const bap_disasm_insn_p_type supported[] = {
 };
 
 class llvm_disassembler : public disassembler_interface {
+    const llvm::Target *target;
+    std::string triple, cpu;
     shared_ptr<const llvm::MCRegisterInfo>  reg_info;
     shared_ptr<const llvm::MCInstrInfo>     ins_info;
     shared_ptr<const llvm::MCSubtargetInfo> sub_info;
@@ -108,10 +111,38 @@ class llvm_disassembler : public disassembler_interface {
     table ins_tab, reg_tab;
     llvm::MCInst mcinst;
     insn current;
-
+    // satisfied predicates of the current instruction, among the
+    // known ones, i.e., those that were already checked.
+    mutable preds_mask mask;
+    mutable preds_mask known;
+
+    // a decoded instruction, with bytes it was decoded from.
+    struct cached_insn {
+        enum { max_size = 16 };
+        llvm::MCInst mcinst;
+        insn decoded;
+        preds_mask mask;
+        preds_mask known;
+        uint8_t bytes[max_size];
+    };
+
+    // decode cache, indexed by instruction address
+    std::unordered_map<int64_t, cached_insn> cache;
+    // the cache entry of the current instruction, if any, its checked
+    // predicates are stored there as well.
+    cached_insn *entry;
+    std::size_t cache_capacity;
+    cache_stats stats;
 
     llvm_disassembler(int debug_level)
-        : debug_level(debug_level), current(invalid_insn({0,0})) {}
+        : debug_level(debug_level)
+        , mask(0)
+        , known(0)
+        , entry(nullptr)
+        , cache_capacity(0)
+        , stats({0,0}) {
+        set_invalid({0,0});
+    }
 
 public:
     static result<llvm_disassembler>
@@ -167,6 +198,39 @@ public:
             return {nullptr, bap_disasm_unsupported_target};
         }
 
+        auto self = create_instance(target, triple, cpu, debug_level,
+                                    reg_info, ins_info, sub_info, asm_info);
+        if (self.dis) {
+            self.dis->ins_tab = self.dis->create_table(ins_info->getNumOpcodes(), ins_info);
+            self.dis->reg_tab = self.dis->create_table(reg_info->getNumRegs(), reg_info);
+        }
+        return self;
+    }
+
+    // creates a disassembler with its own context, printer, and
+    // decoder, that shares target description with the original.
+    shared_ptr<disassembler_interface> clone() const {
+        auto copy = create_instance(target, triple.c_str(), cpu.c_str(),
+                                    debug_level,
+                                    reg_info, ins_info, sub_info, asm_info);
+        if (copy.dis) {
+            copy.dis->ins_tab = ins_tab;
+            copy.dis->reg_tab = reg_tab;
+        }
+        return copy.dis;
+    }
+
+private:
+    // creates the mutable part of a disassembler, i.e., everything
+    // that is not a target description.
+    static result<llvm_disassembler>
+    create_instance(const llvm::Target *target,
+                    const char *triple, const char *cpu, int debug_level,
+                    shared_ptr<const llvm::MCRegisterInfo>  reg_info,
+                    shared_ptr<const llvm::MCInstrInfo>     ins_info,
+                    shared_ptr<const llvm::MCSubtargetInfo> sub_info,
+                    shared_ptr<const llvm::MCAsmInfo>       asm_info) {
+
         shared_ptr<llvm::MCContext> ctx
             (new llvm::MCContext(&*asm_info, &*reg_info, 0));
 
@@ -230,6 +294,9 @@ public:
             &*ctx, rel_info);
 
         shared_ptr<llvm_disassembler> self(new llvm_disassembler(debug_level));
+        self->target = target;
+        self->triple = triple;
+        self->cpu = cpu;
         self->printer  = printer;
         self->reg_info = reg_info;
         self->ins_info = ins_info;
@@ -237,12 +304,10 @@ public:
         self->asm_info = asm_info;
         self->ctx = ctx;
         self->dis = dis;
-        self->ins_tab = self->create_table(ins_info->getNumOpcodes(), ins_info);
-        self->reg_tab = self->create_table(reg_info->getNumRegs(), reg_info);
         return {self, 0};
     }
 
-
+public:
     table insn_table() const {
         return ins_tab;
     }
@@ -256,6 +321,13 @@ public:
     }
 
     void step(int64_t pc) {
+        mask = known = 0;
+        entry = nullptr;
+        if (cache_capacity != 0 && restore(pc)) {
+            stats.hits++;
+            return;
+        }
+
         mcinst.clear();
         uint64_t size = 0;
         auto status = dis->getInstruction
@@ -273,31 +345,47 @@ public:
 
         if (status == llvm::MCDisassembler::Success) {
             if (debug_level > 1) {
-                std::cerr << "read: '" << get_asm() << "'\n";
+                std::string text;
+                append_asm(text);
+                std::cerr << "read: '" << text << "'\n";
             }
-            current = valid_insn(loc);
+            set_valid(loc);
         } else {
             if (debug_level > 0)
                 std::cerr << "failed to decode insn at"
                           << " pc " << pc
                           << " offset " << off
                           << " skipping " << size << " bytes\n";
-            current = invalid_insn(loc);
+            set_invalid(loc);
+        }
+
+        if (cache_capacity != 0) {
+            stats.misses++;
+            remember(pc);
+        }
+    }
+
+    void set_cache_capacity(std::size_t capacity) {
+        cache_capacity = capacity;
+        if (capacity == 0) {
+            entry = nullptr;
+            cache.clear();
         }
     }
 
-    insn get_insn() const {
+    cache_stats get_cache_stats() const {
+        return stats;
+    }
+
+    const insn &get_insn() const {
         return current;
     }
 
-    std::string get_asm() const {
+    void append_asm(std::string &out) const {
         if (current.code != 0) {
-            std::string data;
-            llvm::raw_string_ostream stream(data);
+            llvm::raw_string_ostream stream(out);
             printer->printInst(&mcinst, stream, "");
-            return stream.str();
-        } else {
-            return "";
+            stream.flush();
         }
     }
 
@@ -322,6 +410,21 @@ public:
         }
     }
 
+    // only the predicates in \a wanted, that were not checked yet,
+    // are computed.
+    preds_mask satisfied(preds_mask wanted) const {
+        preds_mask missing = wanted & ~known;
+        if (missing != 0) {
+            mask |= compute_mask(missing);
+            known |= missing;
+            if (entry) {
+                entry->mask = mask;
+                entry->known = known;
+            }
+        }
+        return mask & wanted;
+    }
+
     bool supports(bap_disasm_insn_p_type p) const {
         for (auto q : supported) {
             if (p == q)
@@ -331,8 +434,94 @@ public:
     }
 
 private:
-    insn valid_insn(location loc) const {
-        insn ins;
+    // computes predicates in \a wanted, that are satisfied.
+    preds_mask compute_mask(preds_mask wanted) const {
+        if (current.code == 0)
+            return pred_bit(is_invalid) & wanted;
+
+        auto want = [wanted](bap_disasm_insn_p_type p) {
+            return (wanted & pred_bit(p)) != 0;
+        };
+        auto d = ins_info->get(current.code);
+        preds_mask preds = pred_bit(is_true) & wanted;
+        if (want(is_return) && d.isReturn())
+            preds |= pred_bit(is_return);
+        if (want(is_call) && d.isCall())
+            preds |= pred_bit(is_call);
+        if (want(is_barrier) && d.isBarrier())
+            preds |= pred_bit(is_barrier);
+        if (want(is_terminator) && d.isTerminator())
+            preds |= pred_bit(is_terminator);
+        if (want(is_branch) && d.isBranch())
+            preds |= pred_bit(is_branch);
+        if (want(is_indirect_branch) && d.isIndirectBranch())
+            preds |= pred_bit(is_indirect_branch);
+        if (want(is_conditional_branch) && d.isConditionalBranch())
+            preds |= pred_bit(is_conditional_branch);
+        if (want(is_unconditional_branch) && d.isUnconditionalBranch())
+            preds |= pred_bit(is_unconditional_branch);
+        if (want(may_affect_control_flow) &&
+            d.mayAffectControlFlow(mcinst, *reg_info))
+            preds |= pred_bit(may_affect_control_flow);
+        if (want(may_load) && d.mayLoad())
+            preds |= pred_bit(may_load);
+        if (want(may_store) && d.mayStore())
+            preds |= pred_bit(may_store);
+        return preds;
+    }
+
+    // restores the instruction at \a pc from the cache, if it was
+    // decoded from the same bytes, as there are now.
+    bool restore(int64_t pc) {
+        auto it = cache.find(pc);
+        if (it == cache.end())
+            return false;
+
+        cached_insn &c = it->second;
+        int size = c.decoded.loc.len;
+        uint8_t bytes[cached_insn::max_size];
+        if (mem->readBytes(pc, size, bytes) != 0 ||
+            std::memcmp(bytes, c.bytes, size) != 0)
+            return false;
+
+        mcinst = c.mcinst;
+        current.code = c.decoded.code;
+        current.name = c.decoded.name;
+        current.loc = {(int)(pc - mem->getBase()), size};
+        current.ops.assign(c.decoded.ops.begin(), c.decoded.ops.end());
+        mask = c.mask;
+        known = c.known;
+        entry = &it->second;
+        return true;
+    }
+
+    // stores the current instruction in the cache, unless it is full.
+    // Failed decodes are not stored, as they depend not only on the
+    // bytes, but also on the extent of the memory, e.g., an
+    // instruction truncated by the end of the memory is invalid.
+    void remember(int64_t pc) {
+        int size = current.loc.len;
+        if (current.code == 0 || size == 0 ||
+            size > cached_insn::max_size)
+            return;
+        if (cache.size() >= cache_capacity && cache.count(pc) == 0)
+            return;
+        cached_insn &c = cache[pc];
+        if (mem->readBytes(pc, size, c.bytes) != 0) {
+            cache.erase(pc);
+            return;
+        }
+        c.mcinst = mcinst;
+        c.decoded = current;
+        c.mask = mask;
+        c.known = known;
+        entry = &c;
+    }
+
+    // the current instruction is updated in place, so that the
+    // storage of its operands is reused between steps.
+    void set_valid(location loc) {
+        current.ops.clear();
 
         for (int i = 0; i < mcinst.getNumOperands(); ++i) {
             const llvm::MCOperand &op = mcinst.getOperand(i);
@@ -340,20 +529,23 @@ private:
                 if (debug_level > 0) {
                     std::cerr << "skipping instruction, because of invalid operand\n";
                 }
-                return invalid_insn(loc);
+                set_invalid(loc);
+                return;
             }
 
-            ins.ops.push_back(create_operand(op, loc));
+            current.ops.push_back(create_operand(op, loc));
         }
 
-        ins.code = mcinst.getOpcode();
-        ins.name = ins_info->getName(ins.code) - ins_tab.data;
-        ins.loc = loc;
-        return ins;
+        current.code = mcinst.getOpcode();
+        current.name = ins_info->getName(current.code) - ins_tab.data;
+        current.loc = loc;
     }
 
-    insn invalid_insn(location loc) const {
-        return {0, 0L, loc};
+    void set_invalid(location loc) {
+        current.code = 0;
+        current.name = 0;
+        current.loc = loc;
+        current.ops.clear();
     }
 
     operand create_operand(llvm::MCOperand mcop, location loc) const {
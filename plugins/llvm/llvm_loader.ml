@@ -28,7 +28,7 @@ let to_segment arch s : Backend.Segment.t option =
     Option.some
   | _ -> None
 
-let to_symbol arch s : Backend.Symbol.t option =
+let to_symbol arch s : Backend.Symbol.t =
   let module S = Binary.LLVM.Symbol in
   let name = S.name s in
   let is_function = S.kind s = S.Function in
@@ -36,11 +36,15 @@ let to_symbol arch s : Backend.Symbol.t option =
   let locations = Location.Fields.create
       ~addr:(S.addr s |> make_addr arch)
       ~len:(S.size s |> Int64.to_int_exn), [] in
+  Backend.Symbol.Fields.create ~name ~is_function ~is_debug ~locations
 
-  if S.size s <> Int64.zero then
-    Backend.Symbol.Fields.create ~name ~is_function ~is_debug ~locations |>
-    Option.some
-  else None
+(* symbols of zero size are dropped before they are copied from
+   the image, as they usually make up the bulk of the symbol table *)
+let symbols arch b =
+  List.init (Binary.symbols_count b) ~f:Fn.id |>
+  List.filter_map ~f:(fun n ->
+      if Binary.symbol_size b n = Int64.zero then None
+      else Some (to_symbol arch (Binary.symbol b n)))
 
 let to_section arch s : Backend.Section.t =
   let module S = Binary.LLVM.Section in
@@ -60,13 +64,76 @@ let of_data data : Backend.Img.t option =
     let segments =
       Binary.segments b |> List.filter_map ~f:(to_segment arch) |>
       (fun s -> List.hd_exn s, List.tl_exn s) in
-    let symbols =
-      Binary.symbols b |> List.filter_map ~f:(to_symbol arch) in
+    let symbols = symbols arch b in
     let sections =
       Binary.sections b |> List.map ~f:(to_section arch) in
     Backend.Img.Fields.create ~arch ~entry ~segments ~symbols ~sections in
   Option.try_with of_data_exn
 
+(* Members of an archive are loaded as separate images. Memory of
+   relocatable objects starts at zero, so each member is moved above
+   the previous one, at a page boundary. *)
+module Archive = struct
+  let page_size = 0x1000
+
+  (* the file is mapped by the memory loader, the base of the
+     memory is the contents of the whole file *)
+  let readfile path : Bigstring.t =
+    let zero = Addr.of_int64 ~width:64 0L in
+    Memory.of_file LittleEndian zero path |> ok_exn |>
+    Memory.to_buffer |> Bigsubstring.base
+
+  let rebase endian shift mem =
+    let buf = Memory.to_buffer mem in
+    let pos = Bigsubstring.pos buf and len = Bigsubstring.length buf in
+    let addr = Addr.(Memory.min_addr mem ++ shift) in
+    Memory.create ~pos ~len endian addr (Bigsubstring.base buf) |> ok_exn
+
+  let next_page memory = match Memmap.max_addr memory with
+    | None -> 0
+    | Some addr ->
+      let next = Addr.to_int addr |> ok_exn |> succ in
+      (next + page_size - 1) land lnot (page_size - 1)
+
+  let shift memory img =
+    match Memmap.min_addr (Image.memory img) with
+    | None -> 0
+    | Some addr -> max 0 (next_page memory - ok_exn (Addr.to_int addr))
+
+  let load_member (arch,memory) (member,data) =
+    match Image.of_bigstring ~backend:name data with
+    | Error err ->
+      warning "skipping archive member %s: %a" member Error.pp err;
+      arch,memory
+    | Ok (img,_) when Option.exists arch
+                        ~f:(fun a -> not (Arch.equal a (Image.arch img))) ->
+      warning "skipping archive member %s: architecture mismatch" member;
+      arch,memory
+    | Ok (img,_) ->
+      let shift = shift memory img in
+      let endian = Image.endian img in
+      let memory =
+        Memmap.to_sequence (Image.memory img) |>
+        Seq.fold ~init:memory ~f:(fun memory (mem,v) ->
+            Memmap.add memory (rebase endian shift mem) v) in
+      Some (Image.arch img), memory
+
+  let is_code v =
+    Value.get Image.segment v |>
+    Option.value_map ~default:false ~f:Image.Segment.is_executable
+
+  let load ~jobs path =
+    let data = readfile path in
+    match Binary.members data |>
+          List.fold ~init:(None,Memmap.empty) ~f:load_member with
+    | None,_ -> invalid_argf "archive %s has no loadable members" path ()
+    | Some arch,data ->
+      let code = Memmap.filter data ~f:is_code in
+      Project.Input.create ~jobs arch path ~code ~data
+end
+
+let register_archive_loader ~jobs =
+  Project.Input.register_loader (name ^ "-archive") (Archive.load ~jobs)
 
 let () =
   match Image.register_backend ~name of_data with
@@ -2,3 +2,9 @@ open Core_kernel.Std
 open Bap.Std
 
 val of_data : Bigstring.t -> Backend.Img.t option
+
+(** [register_archive_loader ~jobs] registers the [llvm-archive]
+    project loader, that loads each member of a static library as a
+    separate image, and disassembles members with up to [jobs]
+    processes.  *)
+val register_archive_loader : jobs:int -> unit
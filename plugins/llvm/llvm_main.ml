@@ -14,7 +14,12 @@ let () =
     let doc = sprintf "Choose style of code for x86 syntax between %s"
       @@ Config.doc_enum names in
     Config.(param (enum names) ~default:"att" "x86-syntax" ~doc) in
+  let archive_jobs =
+    let doc = "Number of processes that disassemble members of an \
+               archive, loaded with the llvm-archive loader" in
+    Config.(param int ~default:4 "archive-jobs" ~doc) in
   Config.when_ready (fun {Config.get=(!)} ->
+      Llvm_loader.register_archive_loader ~jobs:!archive_jobs;
       Unix.putenv "BAP_LLVM_OPTIONS" ("-x86-asm-syntax=" ^ !x86_syntax);
       let r = init () in
       if r < 0 then
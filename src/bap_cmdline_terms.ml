@@ -155,6 +155,14 @@ let verbose : bool Term.t =
   let doc = "Print verbose output" in
   Arg.(value & flag & info ["verbose"] ~doc)
 
+let disasm_stats : bool Term.t =
+  let doc = "Print statistics of the disassembler backend, such as
+    the number of decoded instructions and time spent in decoding,
+    as well as CPU cycles and cache misses, if hardware performance
+    counters are available. The project is not loaded from the
+    cache, so that the binary is always disassembled." in
+  Arg.(value & flag & info ["disasm-stats"] ~doc)
+
 let load_doc =
   "Dynamically loads file $(i,PATH).plugin. A plugin must be compiled
    with $(b,bapbuild) tool using $(b,bapbuild PATH.plugin) command."
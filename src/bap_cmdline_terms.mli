@@ -9,6 +9,7 @@ val list_formats_doc : string
 val dump_formats : unit -> fmt_spec list Term.t
 val source_type : source Term.t
 val verbose : bool Term.t
+val disasm_stats : bool Term.t
 val brancher : unit -> string option Term.t
 val symbolizers : unit -> string list Term.t
 val rooters : unit -> string list Term.t
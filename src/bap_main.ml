@@ -117,9 +117,17 @@ let process options project =
             Project.Io.save ~fmt ?ver ch project)
       | `stdout,fmt,ver -> Project.Io.show ~fmt ?ver project)
 
+let print_disasm_stats () =
+  eprintf "@[<v2>Disassembler statistics:@;%a@]@."
+    Disasm.Basic.Stats.pp (Disasm.Basic.Stats.total ())
+
 let main o =
+  if o.disasm_stats then Disasm.Basic.Stats.enable ~counters:true ();
   let digest = digest o in
-  let project = match Project.Cache.load digest with
+  (* a cached project is not disassembled, so there are no statistics *)
+  let cached =
+    if o.disasm_stats then None else Project.Cache.load digest in
+  let project = match cached with
     | Some proj ->
       Project.restore_state proj;
       proj
@@ -136,7 +144,8 @@ let main o =
       | Ok project ->
         Project.Cache.save digest project;
         project in
-  process o project
+  process o project;
+  if o.disasm_stats then print_disasm_stats ()
 
 let program_info =
   let doc = "Binary Analysis Platform" in
@@ -195,8 +204,8 @@ let program_info =
   Term.info "bap" ~version:Config.version ~doc ~man
 let program source =
   let create
-      a b c d e f g i j k = Bap_options.Fields.create
-      a b c d e f g i j k [] in
+      a b c d e f g i j k l = Bap_options.Fields.create
+      a b c d e f g i j k l [] in
   let open Bap_cmdline_terms in
   Term.(const create
         $filename
@@ -208,7 +217,8 @@ let program source =
         $(brancher ())
         $(symbolizers ())
         $(rooters ())
-        $(reconstructor ())),
+        $(reconstructor ())
+        $disasm_stats),
   program_info
 
 let parse_source argv =
@@ -15,5 +15,6 @@ type t = {
   symbolizers     : string list;
   rooters         : string list;
   reconstructor   : string option;
+  disasm_stats    : bool;
   passes          : string list;
 } [@@deriving sexp, fields]